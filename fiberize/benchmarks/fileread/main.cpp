@@ -0,0 +1,108 @@
+#include <fiberize/fiberize.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace fiberize;
+
+const size_t fileSize = 64 * 1024 * 1024;
+const size_t blockSize = 4096;
+const size_t reads = 64 * 1024;
+
+/**
+ * Reads random blocks, keeping the given number of reads in flight. Every completed read is
+ * replaced by a new one into the same block of memory.
+ */
+double readRandom(int file, size_t depth) {
+    std::vector<char> data(depth * blockSize);
+    std::vector<size_t> slots(reads);
+    std::mt19937_64 random(depth);
+    std::uniform_int_distribution<size_t> block(0, fileSize / blockSize - 1);
+
+    auto start = std::chrono::steady_clock::now();
+    io::FileBatch batch;
+    size_t issued = 0;
+    auto issue = [&] (size_t slot) {
+        size_t index = batch.read(file, io::Buffer(&data[slot * blockSize], blockSize), block(random) * blockSize);
+        slots[index] = slot;
+        issued += 1;
+    };
+
+    for (size_t slot = 0; slot < depth; ++slot) {
+        issue(slot);
+    }
+    batch.submit();
+
+    for (size_t index = batch.next(); index != io::FileBatch::none; index = batch.next()) {
+        batch.release(index);
+        if (issued < reads) {
+            issue(slots[index]);
+            batch.submit();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return reads / elapsed.count();
+}
+
+/**
+ * Reads random blocks one call at a time.
+ */
+double readRandomSingle(int file) {
+    char data[blockSize];
+    std::mt19937_64 random(0);
+    std::uniform_int_distribution<size_t> block(0, fileSize / blockSize - 1);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < reads; ++i) {
+        io::Buffer buffer(data, blockSize);
+        io::read(file, &buffer, 1, block(random) * blockSize);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return reads / elapsed.count();
+}
+
+/**
+ * Reads the whole file sequentially with a FileReader.
+ */
+double replay(int file, size_t depth) {
+    auto start = std::chrono::steady_clock::now();
+    io::FileReader reader(file, 0, 64 * 1024, depth);
+    size_t bytes = 0;
+    for (const io::PooledBuffer& chunk : reader) {
+        bytes += chunk.length();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return bytes / elapsed.count() / (1024 * 1024);
+}
+
+int main() {
+    FiberSystem system;
+    system.fiberize();
+
+    // Use tmpfs if possible, we are measuring the submission overhead and not the disk.
+    const char* path = access("/dev/shm", W_OK) == 0 ? "/dev/shm/fiberize-fileread" : "/tmp/fiberize-fileread";
+    int file = io::open(path, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    std::vector<char> chunk(1024 * 1024, 'x');
+    for (size_t offset = 0; offset < fileSize; offset += chunk.size()) {
+        io::Buffer buffer(chunk.data(), chunk.size());
+        io::write<io::Block>(file, &buffer, 1, offset);
+    }
+
+    std::cout << "io::read: " << readRandomSingle(file) << " reads per second" << std::endl;
+    for (size_t depth = 1; depth <= 64; depth *= 2) {
+        std::cout << "FileBatch, queue depth " << depth << ": "
+                  << readRandom(file, depth) << " reads per second" << std::endl;
+    }
+
+    for (size_t depth = 1; depth <= 16; depth *= 4) {
+        std::cout << "FileReader, read-ahead " << depth << ": " << replay(file, depth) << " MiB per second" << std::endl;
+    }
+
+    io::close(file);
+    io::unlink(path);
+    return 0;
+}
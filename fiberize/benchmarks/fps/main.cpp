@@ -5,6 +5,7 @@ using namespace fiberize;
 
 const size_t fibersPerLine = 1000 * 1000;
 const size_t lines = 100;
+const size_t stackSize = 16 * 1024;
 
 Event<void> finished;
 
@@ -14,7 +15,7 @@ void fiber(size_t i) {
     if (i == fibersPerLine) {
         mainThread.send(finished);
     } else {
-        context::system()->fiber(fiber).run_(i+1);
+        context::system()->fiber(fiber).stackSize(stackSize).run_(i+1);
     }
 }
 
@@ -23,7 +24,7 @@ int main() {
     mainThread = system.fiberize();
 
     for (size_t i = 0; i < lines; ++i) {
-        system.fiber(fiber).run_(1);
+        system.fiber(fiber).stackSize(stackSize).run_(1);
     }
 
     for (size_t i = 0; i < lines; ++i) {
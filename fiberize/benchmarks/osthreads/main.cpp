@@ -0,0 +1,40 @@
+#include <fiberize/fiberize.hpp>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+using namespace fiberize;
+using namespace std::literals;
+
+const size_t rounds = 1000;
+
+int main() {
+    FiberSystem system;
+    system.fiberize();
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(rounds);
+
+    for (size_t i = 0; i < rounds; ++i) {
+        // Let the thread go back to the pool.
+        std::this_thread::sleep_for(1ms);
+
+        // Time from starting an OS thread task until it runs.
+        auto start = std::chrono::steady_clock::now();
+        auto started = system.future([] () {
+            return std::chrono::steady_clock::now();
+        }).osthread().run().await().get();
+        latencies.push_back(started - start);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto micros = [] (std::chrono::nanoseconds ns) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(ns).count();
+    };
+
+    std::cout << "median: " << micros(latencies[rounds / 2]) << "us" << std::endl;
+    std::cout << "p99: " << micros(latencies[rounds * 99 / 100]) << "us" << std::endl;
+    std::cout << "max: " << micros(latencies.back()) << "us" << std::endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <fiberize/fiberize.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace fiberize;
+
+const int connections = 100;
+const int messages = 10000;
+const size_t messageSize = 64;
+
+void echo(int socket) {
+    char data[4096];
+    while (size_t n = io::tcp::read(socket, io::Buffer(data, sizeof(data)))) {
+        io::tcp::write(socket, io::Buffer(data, n));
+    }
+    io::close(socket);
+}
+
+int main() {
+    FiberSystem system;
+    system.fiberize();
+
+    int listener = io::tcp::listen("127.0.0.1", 0);
+    uint16_t port = io::tcp::localPort(listener);
+
+    system.fiber([&system, listener] () {
+        for (int i = 0; i < connections; ++i) {
+            int socket = io::tcp::accept(listener);
+            system.fiber(echo).run(socket);
+        }
+        io::close(listener);
+    }).run();
+
+    // Each client sends a message and waits for the echo before sending the next one.
+    auto client = system.future([port] () {
+        int socket = io::tcp::connect("127.0.0.1", port);
+        char data[messageSize] = {};
+        for (int i = 0; i < messages; ++i) {
+            io::tcp::write(socket, io::Buffer(data, messageSize));
+
+            size_t received = 0;
+            while (received < messageSize) {
+                size_t n = io::tcp::read(socket, io::Buffer(data + received, messageSize - received));
+                if (n == 0)
+                    return;
+                received += n;
+            }
+        }
+        io::close(socket);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<FutureRef<void>> refs;
+    for (int i = 0; i < connections; ++i) {
+        refs.push_back(client.copy().run());
+    }
+
+    for (FutureRef<void>& ref : refs) {
+        ref.await();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double roundTrips = double(connections) * messages;
+    std::cout << roundTrips / elapsed.count() << " round trips per second" << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <fiberize/fiberize.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace fiberize;
+
+const uint batch = 32;
+const int rounds = 10000;
+const size_t datagramSize = 64;
+
+/**
+ * Buffers and datagrams for a batch.
+ */
+struct Batch {
+    Batch() : data(batch * datagramSize), datagrams(batch) {
+        for (uint i = 0; i < batch; ++i) {
+            buffers.emplace_back(&data[i * datagramSize], datagramSize);
+        }
+        for (uint i = 0; i < batch; ++i) {
+            datagrams[i].bufs = &buffers[i];
+            datagrams[i].nbufs = 1;
+        }
+    }
+
+    std::vector<char> data;
+    std::vector<io::Buffer> buffers;
+    std::vector<io::udp::Datagram> datagrams;
+};
+
+/**
+ * Echoes every datagram back to the sender.
+ */
+void echo(int socket, bool batched, int datagrams) {
+    Batch b;
+    int echoed = 0;
+    while (echoed < datagrams) {
+        if (batched) {
+            // Every datagram fills its buffer, so it is sent back as is.
+            uint n = io::udp::recvmmsg(socket, b.datagrams.data(), batch);
+            io::udp::sendmmsg(socket, b.datagrams.data(), n);
+            echoed += n;
+        } else {
+            io::Endpoint from;
+            size_t n = io::udp::recvfrom(socket, &b.buffers[0], 1, &from);
+            io::Buffer reply(b.buffers[0].data(), n);
+            io::udp::sendto(socket, &reply, 1, from);
+            echoed += 1;
+        }
+    }
+}
+
+/**
+ * Sends a batch of datagrams and waits for all of them to come back, in a loop.
+ */
+void client(int socket, bool batched, const io::Endpoint& server) {
+    Batch b;
+    for (int r = 0; r < rounds; ++r) {
+        if (batched) {
+            for (uint i = 0; i < batch; ++i) {
+                b.datagrams[i].peer = server;
+            }
+            io::udp::sendmmsg(socket, b.datagrams.data(), batch);
+
+            uint received = 0;
+            while (received < batch) {
+                received += io::udp::recvmmsg(socket, b.datagrams.data() + received, batch - received);
+            }
+        } else {
+            for (uint i = 0; i < batch; ++i) {
+                io::udp::sendto(socket, &b.buffers[i], 1, server);
+            }
+            for (uint i = 0; i < batch; ++i) {
+                io::udp::recvfrom(socket, &b.buffers[i], 1, nullptr);
+            }
+        }
+    }
+}
+
+double run(FiberSystem& system, bool batched) {
+    int server = io::udp::bind("127.0.0.1", 0);
+    int socket = io::udp::bind("127.0.0.1", 0);
+    io::Endpoint endpoint = io::Endpoint::local(server);
+
+    auto start = std::chrono::steady_clock::now();
+    auto echoRef = system.future(echo).run(server, batched, int(batch) * rounds);
+    client(socket, batched, endpoint);
+    echoRef.await();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    io::close(socket);
+    io::close(server);
+    return double(batch) * rounds / elapsed.count();
+}
+
+int main() {
+    FiberSystem system;
+    system.fiberize();
+
+    std::cout << "one datagram per call: " << run(system, false) << " datagrams per second" << std::endl;
+    std::cout << "sendmmsg/recvmmsg:     " << run(system, true) << " datagrams per second" << std::endl;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <fiberize/fiberize.hpp>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+using namespace fiberize;
+using namespace std::literals;
+
+const size_t rounds = 1000;
+
+Event<FiberRef> ping;
+Event<void> pong;
+
+void echo() {
+    for (;;) {
+        FiberRef sender = ping.await();
+        sender.send(pong);
+    }
+}
+
+int main() {
+    FiberSystem system;
+    FiberRef self = system.fiberize();
+    FiberRef echoRef = system.fiber(echo).run();
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(rounds);
+
+    for (size_t i = 0; i < rounds; ++i) {
+        // Give the schedulers time to go idle.
+        std::this_thread::sleep_for(2ms);
+
+        auto start = std::chrono::steady_clock::now();
+        echoRef.send(ping, self);
+        pong.await();
+        latencies.push_back(std::chrono::steady_clock::now() - start);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto micros = [] (std::chrono::nanoseconds ns) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(ns).count();
+    };
+
+    std::cout << "median: " << micros(latencies[rounds / 2]) << "us" << std::endl;
+    std::cout << "p99: " << micros(latencies[rounds * 99 / 100]) << "us" << std::endl;
+    std::cout << "max: " << micros(latencies.back()) << "us" << std::endl;
+    return 0;
+}
@@ -36,6 +36,8 @@ auto Builder<TaskTraits, Entity, MailboxType>::run(Args&&... args) -> typename T
         std::unique_ptr<Mailbox> mailbox(new MailboxType(std::move(mailbox_)));
         auto task = Traits::newTask(std::move(path), std::move(mailbox), pin_,
             detail::bind<Entity, Args...>(std::move(task_), std::forward<Args>(args)...));
+        task->stackSize = stackSize_;
+        task->throughput = throughput_;
 
         /**
          * Create the reference BEFORE starting the task. Otherwise the task could complete
@@ -65,6 +67,8 @@ void Builder<TaskTraits, Entity, MailboxType>::run_(Args&&... args) {
         std::unique_ptr<Mailbox> mailbox(new MailboxType(std::move(mailbox_)));
         auto task = Traits::newTask(std::move(path), std::move(mailbox), pin_,
             detail::bind<Entity, Args...>(std::move(task_), std::forward<Args>(args)...));
+        task->stackSize = stackSize_;
+        task->throughput = throughput_;
         runner_(task);
     }
 }
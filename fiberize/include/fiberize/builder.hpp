@@ -13,6 +13,7 @@
 #include <fiberize/path.hpp>
 #include <fiberize/scheduler.hpp>
 #include <fiberize/detail/runner.hpp>
+#include <fiberize/detail/task.hpp>
 
 namespace fiberize {
 
@@ -41,6 +42,8 @@ private:
         , task_(std::move(task))
         , mailbox_(std::move(mailbox))
         , pin_(pin)
+        , stackSize_(0)
+        , throughput_(detail::defaultThroughput)
         , runner_(runner)
         {}
 
@@ -90,7 +93,7 @@ public:
     /**
      * The name of the entities built by this builder, if they are named.
      */
-    boost::optional<std::string>& name() const {
+    boost::optional<std::string>& name() {
         assert(!invalidated);
         return name_;
     }
@@ -98,7 +101,7 @@ public:
     /**
      * Returns the task.
      */
-    TaskType& task() const {
+    TaskType& task() {
         assert(!invalidated);
         return task_;
     }
@@ -106,7 +109,7 @@ public:
     /**
      * Returns the mailbox.
      */
-    MailboxType& mailbox() const {
+    MailboxType& mailbox() {
         assert(!invalidated);
         return mailbox_;
     }
@@ -114,11 +117,27 @@ public:
     /**
      * Scheduler the entities built by this builder are pinned to.
      */
-    Scheduler*& pin() const {
+    Scheduler*& pin() {
         assert(!invalidated);
         return pin_;
     }
 
+    /**
+     * Stack size of the entities built by this builder in bytes, or 0 for the default.
+     */
+    size_t& stackSize() {
+        assert(!invalidated);
+        return stackSize_;
+    }
+
+    /**
+     * Number of events processed per activation, or 0 for no limit.
+     */
+    size_t& throughput() {
+        assert(!invalidated);
+        return throughput_;
+    }
+
     ///@}
 
     /**
@@ -150,7 +169,7 @@ public:
      * Unpins the task.
      * @note This is the default.
      */
-    Builder& detached() const {
+    Builder& detached() {
         assert(!invalidated);
         pin_ = nullptr;
         return *this;
@@ -159,9 +178,9 @@ public:
     /**
      * Names the task.
      */
-    Builder& named(std::string name) const {
+    Builder& named(std::string name) {
         assert(!invalidated);
-        name_ = name;
+        name_ = std::move(name);
         return *this;
     }
 
@@ -169,12 +188,37 @@ public:
      * Makes the task unnamed.
      * @note This is the default.
      */
-    Builder& unnamed() const {
+    Builder& unnamed() {
         assert(!invalidated);
         name_ = boost::none;
         return *this;
     }
 
+    /**
+     * Sets the stack size of the task in bytes.
+     *
+     * The size is rounded up to a power of two, between 16KB and 8MB. Fibers with small stacks
+     * are cheaper to keep around, but must not use more stack than requested.
+     * @note Only used by microthreads.
+     */
+    Builder& stackSize(size_t bytes) {
+        assert(!invalidated);
+        stackSize_ = bytes;
+        return *this;
+    }
+
+    /**
+     * Sets the number of events the task processes before it gives way to other tasks.
+     *
+     * Once the quota is used up the task is rescheduled behind the tasks that are already waiting,
+     * which bounds the latency a busy actor adds to its neighbours. 0 disables the limit.
+     */
+    Builder& throughput(size_t events) {
+        assert(!invalidated);
+        throughput_ = events;
+        return *this;
+    }
+
     /**
      * Configures the task to execute as a microthread.
      * @note This is the default.
@@ -232,7 +276,7 @@ private:
      * @warning Moves the name.
      * @internal
      */
-    Ident ident() const {
+    Ident ident() {
         if (name_.is_initialized()) {
             return std::move(name_.get());
         } else {
@@ -244,7 +288,9 @@ private:
     boost::optional<std::string> name_;
     TaskType task_;
     MailboxType mailbox_;
-    Scheduler* const pin_;
+    Scheduler* pin_;
+    size_t stackSize_;
+    size_t throughput_;
     void (*runner_)(detail::Task*);
 };
 
@@ -7,6 +7,7 @@
 #ifndef FIBERIZE_CONDITION_HPP
 #define FIBERIZE_CONDITION_HPP
 
+#include <chrono>
 #include <mutex>
 
 #include <fiberize/mutex.hpp>
@@ -34,6 +35,12 @@ public:
      */
     void await(std::unique_lock<Spinlock>& lock);
 
+    /**
+     * Await the condition until the deadline.
+     * @returns whether the condition was signaled. In both cases the @arg lock will be locked.
+     */
+    bool awaitUntil(std::unique_lock<Spinlock>& lock, std::chrono::steady_clock::time_point deadline);
+
     /**
      * Wake up one thread waiting on the condition.
      */
@@ -45,6 +52,16 @@ public:
     void signalAll(std::unique_lock<Spinlock>& lock);
 
 private:
+    /**
+     * Awaits the condition or until expired becomes true.
+     */
+    bool await(std::unique_lock<Spinlock>& lock, const bool& expired);
+
+    /**
+     * Gives up the ticket of a task that stopped waiting. Must be called under the lock.
+     */
+    void abandon(uint64_t ticket);
+
     std::atomic<uint64_t> released;
     uint64_t nextTicket;
     detail::LazyDeque<detail::Task*> queue;
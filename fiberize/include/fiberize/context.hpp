@@ -7,9 +7,11 @@
 #ifndef FIBERIZE_CONTEXT_HPP
 #define FIBERIZE_CONTEXT_HPP
 
+#include <chrono>
 #include <mutex>
 
 #include <fiberize/fiberref.hpp>
+#include <fiberize/handler.hpp>
 #include <fiberize/spinlock.hpp>
 
 namespace fiberize {
@@ -59,7 +61,8 @@ void yield();
 void stop();
 
 /**
- * Processes all pending events.
+ * Processes the pending events, up to the throughput quota set with Builder::throughput(). An
+ * actor that used up its quota is rescheduled behind the other runnable tasks to handle the rest.
  */
 void process();
 
@@ -73,9 +76,15 @@ void process();
  */
 void processUntil(const bool& condition);
 
+/**
+ * Processes events until the condition is true or the deadline passes.
+ * @returns whether the condition is true.
+ */
+bool processUntil(const bool& condition, std::chrono::steady_clock::time_point deadline);
+
 /**
  * Returns reference to the currently running fiber.
- * @note This function performs a memory allocation.
+ * @note This function doesn't allocate, it only increments the reference count of the task.
  */
 FiberRef self();
 
@@ -91,6 +100,11 @@ void process(std::unique_lock<Spinlock>& lock);
  */
 fiberize::detail::Task* task();
 
+/**
+ * Returns the handler arena of the currently running task.
+ */
+fiberize::detail::HandlerArena& handlerArena();
+
 /**
  * Dispatches an event to the handlers.
  */
@@ -99,7 +113,7 @@ void dispatchEvent(const PendingEvent& event);
 /**
  * Binds an event with the given path to a handler.
  */
-HandlerRef bind(const Path& path, std::unique_ptr<fiberize::detail::Handler> handler);
+HandlerRef bind(EventId id, fiberize::detail::HandlerPtr handler);
 
 /**
  * Suspends execution of this task.
@@ -116,6 +130,37 @@ void resume(fiberize::detail::Task* task);
  */
 void resume(fiberize::detail::Task* task, std::unique_lock<Spinlock> lock);
 
+/**
+ * Puts the event into the mailbox of the task and resumes it, if necessary.
+ */
+void deliver(fiberize::detail::Task* task, PendingEvent&& event);
+
+/**
+ * Resumes the current task at the given deadline, unless destroyed earlier.
+ *
+ * The timer lives in the wheel of the current scheduler. If the task still runs there when the
+ * timeout is destroyed the timer is removed immediately, otherwise the scheduler is asked to
+ * remove it.
+ */
+class Timeout {
+public:
+    explicit Timeout(std::chrono::steady_clock::time_point deadline);
+    ~Timeout();
+
+    Timeout(const Timeout&) = delete;
+    Timeout& operator = (const Timeout&) = delete;
+
+    /**
+     * Whether the deadline has passed. Set together with a resume of the task, so it can be
+     * checked like a condition passed to processUntil().
+     */
+    const bool& expired() const;
+
+private:
+    struct State;
+    State* state;
+};
+
 } // namespace detail
 
 ///@}
@@ -1,13 +1,18 @@
 #ifndef FIBERIZE_DETAIL_FIBERREFIMPL_HPP
 #define FIBERIZE_DETAIL_FIBERREFIMPL_HPP
 
+#include <chrono>
+
+#include <boost/optional.hpp>
+
 #include <fiberize/locality.hpp>
 #include <fiberize/path.hpp>
 #include <fiberize/result.hpp>
+#include <fiberize/detail/refrencecounted.hpp>
 
 namespace fiberize {
 
-struct PendingEvent;
+class PendingEvent;
 
 template <typename A>
 class Promise;
@@ -16,8 +21,11 @@ namespace detail {
 
 /**
  * Interface of an fiber reference implementation.
+ *
+ * Local fibers are referenced directly through their tasks, this interface is only used for
+ * references that need custom delivery.
  */
-class FiberRefImpl {
+class FiberRefImpl : public ReferenceCountedAtomic {
 public:
     virtual ~FiberRefImpl() {};
 
@@ -34,7 +42,7 @@ public:
     /**
      * Emits an event for an appropriatly stored value.
      */
-    virtual void send(const PendingEvent& pendingEvent) = 0;
+    virtual void send(PendingEvent&& pendingEvent) = 0;
 };
 
 template <typename A>
@@ -44,6 +52,11 @@ public:
      * Awaits for the result of this future.
      */
     virtual Result<A> await() = 0;
+
+    /**
+     * Awaits for the result of this future until the deadline.
+     */
+    virtual boost::optional<Result<A>> awaitUntil(std::chrono::steady_clock::time_point deadline) = 0;
 };
 
 } // namespace detail
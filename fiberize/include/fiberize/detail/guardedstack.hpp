@@ -0,0 +1,58 @@
+/**
+ * Stack allocator with guard pages.
+ *
+ * @file guardedstack.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_GUARDEDSTACK_HPP
+#define FIBERIZE_DETAIL_GUARDEDSTACK_HPP
+
+#include <cstddef>
+
+#include <boost/context/all.hpp>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * Allocates stacks with mmap, with a PROT_NONE page below the stack.
+ *
+ * A stack overflow hits the guard page and crashes instead of silently corrupting the memory.
+ * Pages are committed by the kernel when they are first touched, so a large stack costs only
+ * the memory that the fiber actually uses.
+ */
+class GuardedStackAllocator {
+public:
+    /**
+     * Creates an allocator of stacks of the given size, rounded up to whole pages.
+     */
+    explicit GuardedStackAllocator(size_t size);
+
+    /**
+     * Allocates a stack.
+     * @throws std::bad_alloc if the memory couldn't be mapped.
+     */
+    boost::context::stack_context allocate();
+
+    /**
+     * Unmaps a stack.
+     */
+    void deallocate(boost::context::stack_context& stack);
+
+    /**
+     * Gives the pages below the given stack pointer back to the kernel.
+     *
+     * The memory stays mapped, touching it again faults in fresh zeroed pages. If lazy is set
+     * MADV_FREE is used when available, so the kernel reclaims the pages only under memory
+     * pressure.
+     */
+    static void release(const boost::context::stack_context& stack, const void* sp, bool lazy = true);
+
+private:
+    size_t size;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_GUARDEDSTACK_HPP
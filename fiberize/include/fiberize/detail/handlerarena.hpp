@@ -0,0 +1,89 @@
+/**
+ * Per task allocator of event handlers.
+ *
+ * @file handlerarena.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_HANDLERARENA_HPP
+#define FIBERIZE_DETAIL_HANDLERARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * Allocates fixed size slots for the handlers of a single task.
+ *
+ * Freed slots go to a free list and are reused by the next bind, so binding and releasing a
+ * handler in a loop (as Event::await does) does not touch the global allocator. Requests larger
+ * than a slot fall back to operator new.
+ *
+ * @warning Not thread-safe, only the task owning the arena can use it.
+ */
+class HandlerArena {
+public:
+    /**
+     * Size of a slot in bytes.
+     */
+    static constexpr size_t slotSize = 128;
+
+    /**
+     * Number of slots allocated at once.
+     */
+    static constexpr size_t chunkSize = 16;
+
+    HandlerArena();
+
+    HandlerArena(const HandlerArena&) = delete;
+    HandlerArena& operator = (const HandlerArena&) = delete;
+
+    /**
+     * Allocates memory for an object of the given size.
+     */
+    inline void* allocate(size_t size) {
+        if (size > slotSize)
+            return ::operator new(size);
+
+        if (free == nullptr)
+            grow();
+
+        Slot* slot = free;
+        free = slot->next;
+        return slot;
+    }
+
+    /**
+     * Frees memory allocated with allocate() for an object of the given size.
+     */
+    inline void deallocate(void* ptr, size_t size) {
+        if (size > slotSize) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        Slot* slot = reinterpret_cast<Slot*>(ptr);
+        slot->next = free;
+        free = slot;
+    }
+
+private:
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<slotSize, alignof(std::max_align_t)>::type storage;
+    };
+
+    void grow();
+
+    Slot* free;
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_HANDLERARENA_HPP
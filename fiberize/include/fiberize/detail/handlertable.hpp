@@ -0,0 +1,85 @@
+/**
+ * Flat hash table of event handlers.
+ *
+ * @file handlertable.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_HANDLERTABLE_HPP
+#define FIBERIZE_DETAIL_HANDLERTABLE_HPP
+
+#include <memory>
+#include <vector>
+
+#include <fiberize/eventid.hpp>
+#include <fiberize/handler.hpp>
+
+namespace fiberize {
+namespace detail {
+
+using HandlerBlock = std::vector<HandlerPtr>;
+
+/**
+ * Maps event identifiers to handler blocks.
+ *
+ * Open addressing with linear probing and backward shift deletion, so there are no tombstones.
+ * The table keeps the load factor below 1/2. Handler blocks can be moved when the table grows
+ * or an entry is erased, but their elements stay in place.
+ */
+class HandlerTable {
+public:
+    HandlerTable();
+
+    /**
+     * Returns the block of the given event or nullptr if there is none.
+     */
+    HandlerBlock* find(EventId id);
+
+    /**
+     * Returns the block of the given event, inserting an empty one if necessary.
+     */
+    HandlerBlock& operator [] (EventId id);
+
+    /**
+     * Removes the block of the given event.
+     */
+    void erase(EventId id);
+
+    /**
+     * Removes all blocks.
+     */
+    void clear();
+
+    /**
+     * Returns the number of blocks.
+     */
+    inline size_t size() const { return size_; }
+
+private:
+    /**
+     * Marks an empty slot. The registry never assigns this identifier.
+     */
+    static constexpr EventId emptyId = ~EventId(0);
+
+    struct Slot {
+        EventId id;
+        HandlerBlock block;
+    };
+
+    inline size_t home(EventId id) const {
+        // Fibonacci hashing, unique tokens differ mostly in the low bits.
+        return size_t((id * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    size_t locate(EventId id) const;
+    void grow();
+
+    std::vector<Slot> slots;
+    size_t size_;
+    size_t mask;
+    unsigned shift;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_HANDLERTABLE_HPP
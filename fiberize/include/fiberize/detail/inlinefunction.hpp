@@ -0,0 +1,181 @@
+/**
+ * Type erased function with an inline buffer.
+ *
+ * @file inlinefunction.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_INLINEFUNCTION_HPP
+#define FIBERIZE_DETAIL_INLINEFUNCTION_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fiberize {
+namespace detail {
+
+template <typename Signature, size_t Capacity>
+class InlineFunction;
+
+/**
+ * A move-only replacement for std::function that stores the callable in place.
+ *
+ * Callables that fit in Capacity bytes and are nothrow move constructible do not allocate,
+ * larger ones are allocated on the heap.
+ */
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R (Args...), Capacity> {
+public:
+    /**
+     * Size of the inline buffer in bytes.
+     */
+    static constexpr size_t inlineCapacity = Capacity;
+
+    /**
+     * Creates an empty function.
+     */
+    inline InlineFunction() : ops(nullptr) {}
+
+    /**
+     * Wraps a callable.
+     */
+    template <typename F, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+    InlineFunction(F&& f) : ops(nullptr) {
+        using Fn = typename std::decay<F>::type;
+        if (fitsInline<Fn>()) {
+            new (&storage.buffer) Fn(std::forward<F>(f));
+            ops = &InlineOps<Fn>::ops;
+        } else {
+            storage.heap = new Fn(std::forward<F>(f));
+            ops = &HeapOps<Fn>::ops;
+        }
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator = (const InlineFunction&) = delete;
+
+    inline InlineFunction(InlineFunction&& other) noexcept : ops(nullptr) {
+        take(other);
+    }
+
+    inline InlineFunction& operator = (InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    inline ~InlineFunction() {
+        reset();
+    }
+
+    /**
+     * Calls the function.
+     * @warning The function must not be empty.
+     */
+    inline R operator () (Args... args) {
+        return ops->invoke(storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Destroys the callable.
+     */
+    inline void reset() {
+        if (ops != nullptr) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    /**
+     * Whether the function is not empty.
+     */
+    inline explicit operator bool () const {
+        return ops != nullptr;
+    }
+
+    /**
+     * Whether a callable of type F is stored inline.
+     */
+    template <typename F>
+    static constexpr bool fitsInline() {
+        return sizeof(F) <= Capacity
+            && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    union Storage {
+        void* heap;
+        typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type buffer;
+    };
+
+    struct Ops {
+        R (*invoke)(Storage& storage, Args... args);
+        void (*move)(Storage& to, Storage& from);
+        void (*destroy)(Storage& storage);
+    };
+
+    template <typename F>
+    struct InlineOps {
+        static R invoke(Storage& storage, Args... args) {
+            return (*reinterpret_cast<F*>(&storage.buffer))(std::forward<Args>(args)...);
+        }
+
+        static void move(Storage& to, Storage& from) {
+            F* f = reinterpret_cast<F*>(&from.buffer);
+            new (&to.buffer) F(std::move(*f));
+            f->~F();
+        }
+
+        static void destroy(Storage& storage) {
+            reinterpret_cast<F*>(&storage.buffer)->~F();
+        }
+
+        static constexpr Ops ops = { invoke, move, destroy };
+    };
+
+    template <typename F>
+    struct HeapOps {
+        static R invoke(Storage& storage, Args... args) {
+            return (*reinterpret_cast<F*>(storage.heap))(std::forward<Args>(args)...);
+        }
+
+        static void move(Storage& to, Storage& from) {
+            to.heap = from.heap;
+        }
+
+        static void destroy(Storage& storage) {
+            delete reinterpret_cast<F*>(storage.heap);
+        }
+
+        static constexpr Ops ops = { invoke, move, destroy };
+    };
+
+    inline void take(InlineFunction& other) noexcept {
+        if (other.ops != nullptr) {
+            other.ops->move(storage, other.storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+
+    const Ops* ops;
+    Storage storage;
+};
+
+template <typename R, typename... Args, size_t Capacity>
+template <typename F>
+constexpr typename InlineFunction<R (Args...), Capacity>::Ops InlineFunction<R (Args...), Capacity>::InlineOps<F>::ops;
+
+template <typename R, typename... Args, size_t Capacity>
+template <typename F>
+constexpr typename InlineFunction<R (Args...), Capacity>::Ops InlineFunction<R (Args...), Capacity>::HeapOps<F>::ops;
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_INLINEFUNCTION_HPP
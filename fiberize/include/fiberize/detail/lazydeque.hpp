@@ -65,6 +65,12 @@ public:
         queue.get().push_back(value);
     }
 
+    void push_back(A&& value) {
+        if (!queue)
+            queue.emplace();
+        queue.get().push_back(std::move(value));
+    }
+
     void pop_front() {
         queue.get().pop_front();
     }
@@ -85,6 +91,10 @@ public:
         return !queue || queue.get().empty();
     }
 
+    void clear() {
+        queue = boost::none;
+    }
+
     A& operator [] (size_t index) {
         return queue.get()[index];
     }
@@ -7,23 +7,33 @@
 #ifndef FIBERIZE_DETAIL_MULTITASKSCHEDULER_HPP
 #define FIBERIZE_DETAIL_MULTITASKSCHEDULER_HPP
 
+#include <array>
 #include <thread>
 
 #include <fiberize/scheduler.hpp>
+#include <fiberize/detail/workstealingdeque.hpp>
+#include <fiberize/detail/stackpool.hpp>
+#include <fiberize/detail/topology.hpp>
 
 namespace fiberize {
 namespace detail {
 
-class StackPool;
-
 /**
  * @ingroup lifecycle
  */
 class MultiTaskScheduler : public Scheduler {
 public:
-    MultiTaskScheduler(FiberSystem* system, uint64_t seed);
+    /**
+     * Creates a scheduler that will run on the given CPU, using the stack pool of its node.
+     * The thread is pinned to the CPU only if pin is true, otherwise the location is a hint
+     * used to choose the victims of work stealing.
+     */
+    MultiTaskScheduler(FiberSystem* system, uint64_t seed, const CpuLocation& location, bool pin);
     virtual ~MultiTaskScheduler();
 
+    /**
+     * Starts the thread. All schedulers of the system must be created at this point.
+     */
     void start();
     void stop();
 
@@ -32,18 +42,65 @@ public:
     void yield() override;
     Task* currentTask() override;
     bool isMultiTasking() override;
+    void park() override;
+
+    /**
+     * The CPU this scheduler runs on.
+     */
+    inline const CpuLocation& location() const { return location_; }
+
+protected:
+    bool canPark() override;
 
 private:
     std::thread thread;
     std::atomic<bool> stopping;
-
-    std::deque<Task*> softTasks;
-    Spinlock softMutex;
+    CpuLocation location_;
+    bool pin;
+
+    /**
+     * Other schedulers grouped by their distance from this one. Work is stolen from the closest
+     * ones first and parked schedulers are woken up in the same order.
+     */
+    std::array<std::vector<MultiTaskScheduler*>, distanceLevels> neighbours;
+    void findNeighbours();
+
+    /**
+     * Whether this scheduler was woken up and didn't find any work yet.
+     */
+    bool searching;
+    void stopSearching();
+
+    /**
+     * Wakes up one parked scheduler, unless some scheduler is already looking for work.
+     */
+    void wakeSleeper();
+
+    /**
+     * Tasks resumed by other threads. They are moved to the run queues by the owner.
+     */
+    std::atomic<Task*> inbox;
+    void pushInbox(Task* task);
+    void drainInbox();
+    void enqueue(Task* task);
+
+    /**
+     * Tasks that yielded or used up their throughput quota. They run after all other local work,
+     * so they can't take the place of the tasks waiting behind them. The owner takes them from the
+     * top of the deque, like thieves do, which keeps them in FIFO order.
+     */
+    WorkStealingDeque<Task*> yieldedTasks;
+    std::deque<Task*> pinnedYieldedTasks;
+    void requeue(Task* task, std::unique_lock<Spinlock> lock);
+    void dequeueYielded(Task*& task);
+
+    WorkStealingDeque<Task*> softTasks;
+    std::deque<Task*> pinnedSoftTasks;
     void dequeueSoft(Task*& task);
     void stealSoft(Task*& task);
 
-    std::deque<Task*> hardTasks;
-    Spinlock hardMutex;
+    WorkStealingDeque<Task*> hardTasks;
+    std::deque<Task*> pinnedHardTasks;
     void dequeueHard(Task*& task);
     void stealHard(Task*& task);
 
@@ -60,10 +117,7 @@ private:
     static void ownedLoop();
     static void unownedLoop();
 
-    struct UnownedContext {
-        boost::context::fcontext_t context;
-        boost::context::stack_context stack;
-    };
+    using UnownedContext = PooledContext;
 
     uint64_t sameStreak;
     Task* suspendingTask;
@@ -71,17 +125,17 @@ private:
     UnownedContext* unowned;
     boost::context::fcontext_t initialContext;
 
-    std::vector<UnownedContext*> stash;
-    UnownedContext* stashGet();
-    void stashPut(UnownedContext* context);
-    void stashClear();
+    /**
+     * Unowned context abandoned after switching to a context with a different stack size.
+     */
+    UnownedContext* abandoned;
 
-#ifdef FIBERIZE_SEGMENTED_STACKS
-    boost::context::segmented_stack stackAllocator;
-#else
-    boost::context::fixedsize_stack stackAllocator;
-#endif
+    /**
+     * Returns the stack size class a task should run with.
+     */
+    static size_t stackClassOf(Task* task);
 
+    StackPool stacks;
 };
 
 } // namespace detail
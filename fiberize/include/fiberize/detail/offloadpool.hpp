@@ -0,0 +1,150 @@
+/**
+ * Pool of threads executing blocking calls.
+ *
+ * @file offloadpool.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_OFFLOADPOOL_HPP
+#define FIBERIZE_DETAIL_OFFLOADPOOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include <fiberize/detail/refrencecounted.hpp>
+
+namespace fiberize {
+
+/**
+ * A snapshot of the state of the offload pool.
+ *
+ * @ingroup fiberize
+ */
+struct OffloadStats {
+    /**
+     * Number of threads in the pool.
+     */
+    size_t threads;
+
+    /**
+     * Number of threads waiting for work.
+     */
+    size_t idle;
+
+    /**
+     * Number of calls being executed.
+     */
+    size_t running;
+
+    /**
+     * Number of calls waiting for a thread.
+     */
+    size_t queued;
+
+    /**
+     * Number of calls completed since the system was started.
+     */
+    uint64_t completed;
+};
+
+namespace detail {
+
+class Task;
+
+/**
+ * A call submitted to the offload pool by a fiber.
+ */
+class OffloadJob : public ReferenceCountedAtomic {
+public:
+    OffloadJob();
+    virtual ~OffloadJob();
+
+    /**
+     * Executes the call and stores the result.
+     */
+    virtual void execute() = 0;
+
+    /**
+     * The waiting task, resumed when the call completes.
+     */
+    Task* task;
+
+    /**
+     * Whether the call completed. Protected by the task's spinlock.
+     */
+    bool done;
+};
+
+/**
+ * Runs offloaded calls on threads that are not running any scheduler.
+ *
+ * Threads are started when a call finds no idle thread, up to the maximum. A thread that stays
+ * idle for longer than the idle timeout exits.
+ */
+class OffloadPool {
+public:
+    static constexpr size_t defaultMaxThreads = 64;
+    static constexpr std::chrono::seconds defaultIdleTimeout{10};
+
+    OffloadPool();
+
+    /**
+     * Waits for the queued calls and stops all threads.
+     */
+    ~OffloadPool();
+
+    OffloadPool(const OffloadPool&) = delete;
+    OffloadPool& operator = (const OffloadPool&) = delete;
+
+    /**
+     * Queues a call, starting a thread if necessary. The pool holds a reference to the job until
+     * the waiting task is resumed.
+     */
+    void submit(OffloadJob* job);
+
+    /**
+     * Sets the maximum number of threads. Threads above the limit exit when they become idle.
+     */
+    void maxThreads(size_t maxThreads);
+
+    /**
+     * Sets how long a thread waits for a call before exiting.
+     */
+    void idleTimeout(std::chrono::nanoseconds timeout);
+
+    /**
+     * Returns the current state of the pool.
+     */
+    OffloadStats stats();
+
+private:
+    void work(std::list<std::thread>::iterator self);
+
+    /**
+     * Joins the threads that exited.
+     */
+    void joinFinished();
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable exited;
+    std::deque<OffloadJob*> queue;
+    std::list<std::thread> workers;
+    std::list<std::thread> finished;
+    size_t maxThreads_;
+    std::chrono::nanoseconds idleTimeout_;
+    size_t idle;
+    size_t running;
+    uint64_t completed;
+    bool stopping;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_OFFLOADPOOL_HPP
@@ -0,0 +1,95 @@
+/**
+ * Pool of threads running OS thread tasks.
+ *
+ * @file osthreadpool.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_OSTHREADPOOL_HPP
+#define FIBERIZE_DETAIL_OSTHREADPOOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace fiberize {
+
+class FiberSystem;
+
+namespace detail {
+
+class Task;
+
+/**
+ * Runs tasks started with Builder::osthread().
+ *
+ * Every thread owns a SingleTaskScheduler, with its IO context, which is reused by the tasks it
+ * runs. When a task finishes the thread parks and waits for the next one, so starting a task
+ * usually takes a wakeup instead of creating a thread and a libuv loop. At most maxIdle threads
+ * are kept, and they exit after staying idle for longer than the idle timeout.
+ */
+class OSThreadPool {
+public:
+    static constexpr size_t defaultMaxIdle = 16;
+    static constexpr std::chrono::seconds defaultIdleTimeout{10};
+
+    explicit OSThreadPool(FiberSystem* system);
+
+    /**
+     * Stops the idle threads. Threads running tasks are detached and exit when their tasks end.
+     */
+    ~OSThreadPool();
+
+    OSThreadPool(const OSThreadPool&) = delete;
+    OSThreadPool& operator = (const OSThreadPool&) = delete;
+
+    /**
+     * Starts the task on an idle thread, or on a new one if there are none.
+     */
+    void run(Task* task, uint64_t seed);
+
+    /**
+     * Sets the maximum number of idle threads.
+     */
+    void maxIdle(size_t maxIdle);
+
+    /**
+     * Sets how long an idle thread waits for a task before exiting.
+     */
+    void idleTimeout(std::chrono::nanoseconds timeout);
+
+    /**
+     * Returns the number of idle threads.
+     */
+    size_t idle();
+
+private:
+    /**
+     * State shared with the threads, which can outlive the pool.
+     */
+    struct State {
+        std::mutex mutex;
+        std::condition_variable available;
+        std::condition_variable exited;
+        std::deque<Task*> queue;
+        size_t maxIdle;
+        std::chrono::nanoseconds idleTimeout;
+        size_t threads;
+        size_t busy;
+        size_t idle;
+        bool stopping;
+    };
+
+    static void work(std::shared_ptr<State> state, FiberSystem* system, uint64_t seed);
+
+    FiberSystem* system;
+    std::shared_ptr<State> state;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_OSTHREADPOOL_HPP
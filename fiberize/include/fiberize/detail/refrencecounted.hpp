@@ -23,13 +23,20 @@ public:
      * Increases the reference count by 1.
      * @note Thread-safe.
      */
-    void grab();
+    inline void grab() {
+        count.fetch_add(1u, std::memory_order_relaxed);
+    }
 
     /**
      * Decreases the reference count by 1. When the count goes down to 0 the object is destroyed.
      * @note Thread-safe.
      */
-    void drop();
+    inline void drop() {
+        if (count.fetch_sub(1u, std::memory_order_release) == 1u) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            delete this;
+        }
+    }
 
 private:
     std::atomic<uint32_t> count;
@@ -19,9 +19,17 @@ namespace detail {
  */
 class SingleTaskScheduler : public Scheduler {
 public:
+    /**
+     * Creates a scheduler running the given task, or no task if it's nullptr.
+     */
     SingleTaskScheduler(FiberSystem* system, uint64_t seed, Task* task);
     virtual ~SingleTaskScheduler();
 
+    /**
+     * Makes the scheduler run another task. The previous one is not touched, it must be dead.
+     */
+    void assign(Task* task);
+
     void resume(std::unique_lock<Spinlock> lock);
 
     // Scheduler
@@ -30,6 +38,9 @@ public:
     detail::Task* currentTask() override;
     bool isMultiTasking() override;
 
+protected:
+    bool canPark() override;
+
 private:
     Task* task_;
     std::atomic<bool> resumed;
@@ -0,0 +1,159 @@
+/**
+ * Pools of stacks used by the schedulers.
+ *
+ * @file stackpool.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_STACKPOOL_HPP
+#define FIBERIZE_DETAIL_STACKPOOL_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <boost/context/all.hpp>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * A stack together with the execution context created on it.
+ */
+struct PooledContext {
+    boost::context::fcontext_t context;
+    boost::context::stack_context stack;
+    size_t sizeClass;
+};
+
+/**
+ * Stack size classes.
+ *
+ * Classes are powers of two, from minStackSize up to maxStackSize.
+ */
+struct StackClasses {
+    static constexpr size_t minStackSize = 16 * 1024;
+    static constexpr size_t count = 10;
+    static constexpr size_t maxStackSize = minStackSize << (count - 1);
+
+    /**
+     * Returns the smallest class fitting a stack of the given size. Zero means the default size.
+     */
+    static size_t classOf(size_t size);
+
+    /**
+     * Returns the stack size of the given class.
+     */
+    static inline size_t sizeOf(size_t sizeClass) {
+        return minStackSize << sizeClass;
+    }
+
+    /**
+     * Returns the class of the default stack size.
+     */
+    static size_t defaultClass();
+};
+
+/**
+ * Pool shared by all schedulers of a fiber system.
+ *
+ * Schedulers move contexts here when their own pools grow over the high watermark and take
+ * them back when they run out.
+ *
+ * @note Thread-safe.
+ */
+class GlobalStackPool {
+public:
+    GlobalStackPool();
+    ~GlobalStackPool();
+
+    GlobalStackPool(const GlobalStackPool&) = delete;
+    GlobalStackPool& operator = (const GlobalStackPool&) = delete;
+
+    /**
+     * Moves up to n contexts of the given class to the vector.
+     */
+    void take(size_t sizeClass, std::vector<PooledContext*>& to, size_t n);
+
+    /**
+     * Moves the last n contexts from the vector to the pool. Contexts over the capacity are freed.
+     */
+    void give(size_t sizeClass, std::vector<PooledContext*>& from, size_t n);
+
+    /**
+     * A scheduler keeps at least this many contexts of a class after giving some away, and
+     * takes this many at once from the global pool.
+     */
+    std::atomic<size_t> lowWatermark;
+
+    /**
+     * A scheduler gives contexts away when it has more than this many of a class.
+     */
+    std::atomic<size_t> highWatermark;
+
+    /**
+     * Maximum number of contexts of a class kept in the global pool.
+     */
+    std::atomic<size_t> capacity;
+
+    /**
+     * Whether pooled guarded stacks give their unused pages back with MADV_FREE, which keeps them
+     * resident until the kernel needs the memory, instead of dropping them at once.
+     */
+    std::atomic<bool> lazyRelease;
+
+private:
+    std::mutex mutex;
+    std::vector<PooledContext*> classes[StackClasses::count];
+};
+
+/**
+ * Pool of contexts owned by a single scheduler.
+ *
+ * @warning Not thread-safe.
+ */
+class StackPool {
+public:
+    /**
+     * Creates a pool. New contexts start executing the given function.
+     */
+    StackPool(GlobalStackPool* global, void (*entry)(intptr_t));
+    ~StackPool();
+
+    StackPool(const StackPool&) = delete;
+    StackPool& operator = (const StackPool&) = delete;
+
+    /**
+     * Returns a context of the given class, creating a new one if necessary.
+     */
+    PooledContext* get(size_t sizeClass);
+
+    /**
+     * Returns a context to the pool.
+     */
+    void put(PooledContext* context);
+
+    /**
+     * Frees all contexts in this pool.
+     */
+    void clear();
+
+    /**
+     * Creates a new context with a stack of the given class.
+     */
+    static PooledContext* create(size_t sizeClass, void (*entry)(intptr_t));
+
+    /**
+     * Frees the context and its stack.
+     */
+    static void destroy(PooledContext* context);
+
+private:
+    GlobalStackPool* global;
+    void (*entry)(intptr_t);
+    std::vector<PooledContext*> classes[StackClasses::count];
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_STACKPOOL_HPP
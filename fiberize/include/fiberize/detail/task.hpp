@@ -13,6 +13,7 @@
 #include <fiberize/promise.hpp>
 #include <fiberize/spinlock.hpp>
 #include <fiberize/detail/runnable.hpp>
+#include <fiberize/detail/handlertable.hpp>
 #include <fiberize/detail/refrencecounted.hpp>
 
 #include <iostream>
@@ -56,6 +57,10 @@ namespace detail {
  * is satisfied (or instantly in the case of yield()) it will be rescheduled and when a scheduler picks up the task it will be
  * resumed.
  *
+ * A Listening actor has no stack. The multitask scheduler runs its handlers directly on the stack the scheduler loop is
+ * currently using, without a context switch. Only when a handler suspends the stack is promoted: it becomes owned by the actor
+ * until the actor goes back to Listening, and the scheduler continues on a fresh stack from its pool.
+ *
  */
 ///@{
 
@@ -89,18 +94,27 @@ enum TaskStatus : uint8_t {
     Dead
 };
 
-using HandlerBlock = std::vector<std::unique_ptr<detail::Handler>>;
+/**
+ * Default number of events a task processes before giving way to other tasks.
+ */
+constexpr size_t defaultThroughput = 256;
 
-class Task {
+class Task : public ReferenceCountedAtomic {
 public:
+    /**
+     * Creates a task holding its life reference, which is dropped by Scheduler::kill.
+     */
     Task()
         : status(Starting)
         , scheduled(false)
         , handlersInitialized(false)
         , resumes(0)
         , stopped(false)
-        , refCount(0)
-        {}
+        , stackSize(0)
+        , throughput(defaultThroughput)
+        , inboxNext(nullptr) {
+        grab();
+    }
 
     virtual ~Task() {}
 
@@ -155,56 +169,42 @@ public:
     bool stopped;
 
     /**
-     * Reference count.
+     * Stack size requested for this task in bytes, or 0 for the default.
+     * @note Only used by microthreads.
      */
-    uint32_t refCount;
+    size_t stackSize;
 
     /**
-     * Hash map of event handlers.
+     * Maximum number of events processed in one activation before the task is rescheduled,
+     * or 0 for no limit.
      */
-    std::unordered_map<Path, detail::HandlerBlock, boost::hash<Path>> handlers;
+    size_t throughput;
 
     /**
-     * Mailbox attached to this task.
+     * Next task in the inbox of a multitask scheduler.
      */
-    std::unique_ptr<Mailbox> mailbox;
+    Task* inboxNext;
 
     /**
-     * Function used to execute this task.
+     * Memory for the event handlers. Must outlive the handlers.
      */
-    std::unique_ptr<detail::ErasedRunnable> runnable;
+    HandlerArena handlerArena;
 
     /**
-     * Increases the reference count by 1.
-     * @note Thread-safe.
+     * Hash map of event handlers.
      */
-    inline void grab() {
-        std::unique_lock<Spinlock> lock(spinlock);
-        refCount += 1;
-    }
+    HandlerTable handlers;
 
     /**
-     * Decreases the reference count by 1. When the count goes down to 0
-     * and the task is dead the object is destroyed.
-     * @note Thread-safe.
+     * Mailbox attached to this task.
      */
-    inline void drop() {
-        std::unique_lock<Spinlock> lock(spinlock);
-        refCount -= 1;
-        if (refCount == 0 && status == Dead) {
-            lock.release();
-            delete this;
-        }
-    }
-};
-
-inline void intrusive_ptr_add_ref(Task* task) {
-    task->grab();
-}
+    std::unique_ptr<Mailbox> mailbox;
 
-inline void intrusive_ptr_release(Task* task) {
-    task->drop();
-}
+    /**
+     * Function used to execute this task.
+     */
+    std::unique_ptr<detail::ErasedRunnable> runnable;
+};
 
 template <typename A>
 class Future : public Task {
@@ -11,9 +11,8 @@
 
 #include <fiberize/path.hpp>
 #include <fiberize/fiberref.hpp>
+#include <fiberize/fiberref-inl.hpp>
 #include <fiberize/detail/task.hpp>
-#include <fiberize/detail/devnullfiberref.hpp>
-#include <fiberize/detail/localfiberref.hpp>
 
 namespace fiberize {
 namespace detail {
@@ -25,14 +24,11 @@ struct FiberTraits {
         using TaskType = Task;
 
         inline static RefType devNullRef() {
-            auto impl = std::shared_ptr<FiberRefImpl>(
-                std::shared_ptr<FiberRefImpl>(), &devNullFiberRef);
-            return FiberRef(impl);
+            return FiberRef();
         }
 
-        inline static RefType localRef(FiberSystem* system, TaskType* task) {
-            auto impl = std::make_shared<LocalFiberRef>(system, task);
-            return FiberRef(impl);
+        inline static RefType localRef(FiberSystem*, TaskType* task) {
+            return FiberRef(task);
         }
 
         template <typename Runnable>
@@ -62,14 +58,11 @@ struct ActorTraits {
         using TaskType = Task;
 
         inline static RefType devNullRef() {
-            auto impl = std::shared_ptr<FiberRefImpl>(
-                std::shared_ptr<FiberRefImpl>(), &devNullFiberRef);
-            return FiberRef(impl);
+            return FiberRef();
         }
 
-        inline static RefType localRef(FiberSystem* system, TaskType* task) {
-            auto impl = std::make_shared<LocalFiberRef>(system, task);
-            return FiberRef(impl);
+        inline static RefType localRef(FiberSystem*, TaskType* task) {
+            return FiberRef(task);
         }
 
         template <typename Runnable>
@@ -118,14 +111,11 @@ struct FutureTraits {
         using TaskType = Future<A>;
 
         static RefType devNullRef() {
-            auto impl = std::shared_ptr<FutureRefImpl<A>>(
-                std::shared_ptr<FutureRefImpl<A>>(), &devNullFutureRef<A>);
-            return FutureRef<A>(impl);
+            return FutureRef<A>();
         }
 
-        static RefType localRef(FiberSystem* system, TaskType* task) {
-            auto impl = std::make_shared<LocalFutureRef<A>>(system, task);
-            return FutureRef<A>(impl);
+        static RefType localRef(FiberSystem*, TaskType* task) {
+            return FutureRef<A>(task);
         }
 
         template <typename Runnable>
@@ -0,0 +1,155 @@
+/**
+ * Hierarchical timing wheel.
+ *
+ * @file timerwheel.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_TIMERWHEEL_HPP
+#define FIBERIZE_DETAIL_TIMERWHEEL_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * A timer registered in a TimerWheel. The memory is owned by the user, the wheel only links it
+ * into its lists.
+ */
+struct Timer {
+    /**
+     * Called when the timer expires, after it is removed from the wheel.
+     */
+    void (*expired)(Timer* timer);
+
+    /**
+     * Called by the owner of the wheel when it processes a cancellation requested with
+     * TimerWheel::cancelConcurrent(). The timer isn't in the wheel anymore, removed tells whether
+     * the cancellation removed it or it had expired before.
+     */
+    void (*withdrawn)(Timer* timer, bool removed) = nullptr;
+
+    /**
+     * Expiration time in milliseconds.
+     */
+    uint64_t deadline;
+
+    Timer* prev;
+    Timer* next;
+    Timer* nextCancelled;
+    uint8_t level;
+    uint8_t slot;
+    bool scheduled = false;
+};
+
+/**
+ * Hierarchical timing wheel with a resolution of one millisecond.
+ *
+ * Level k has 64 slots, each covering 64^k milliseconds. A timer is put into the lowest level
+ * whose slots still distinguish its deadline from the current time. When the time reaches a
+ * slot of a higher level its timers are moved to the lower levels. Inserting and cancelling a
+ * timer is O(1), finding the next expiration scans one bitmap per level.
+ *
+ * @warning Not thread-safe, each scheduler has its own wheel. The only exception is
+ *          cancelConcurrent().
+ */
+class TimerWheel {
+public:
+    static constexpr size_t levelBits = 6;
+    static constexpr size_t slots = size_t(1) << levelBits;
+
+    /**
+     * Enough levels to cover the whole 64 bit range, so that no deadline needs clamping.
+     */
+    static constexpr size_t levels = (64 + levelBits - 1) / levelBits;
+
+    /**
+     * Returned by nextExpiration() if there are no timers.
+     */
+    static constexpr uint64_t never = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * Creates an empty wheel starting at the current time.
+     */
+    TimerWheel();
+
+    /**
+     * Forgets the pending timers, without calling them.
+     */
+    ~TimerWheel() = default;
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator = (const TimerWheel&) = delete;
+
+    /**
+     * Returns the monotonic time in milliseconds, as used by deadlines.
+     */
+    static uint64_t now();
+
+    /**
+     * Converts a point in time to a deadline, rounding up.
+     */
+    static uint64_t deadlineOf(std::chrono::steady_clock::time_point time);
+
+    /**
+     * Schedules the timer to expire at the given deadline. A deadline in the past expires
+     * during the next advance().
+     */
+    void schedule(Timer* timer, uint64_t deadline);
+
+    /**
+     * Removes a scheduled timer from the wheel.
+     */
+    void cancel(Timer* timer);
+
+    /**
+     * Asks the owner of the wheel to remove the timer. The request is processed by the next call to
+     * collectCancelled(), which calls the withdrawn callback of the timer.
+     * @note Thread-safe.
+     */
+    void cancelConcurrent(Timer* timer);
+
+    /**
+     * Processes the cancellations requested with cancelConcurrent().
+     */
+    void collectCancelled();
+
+    /**
+     * Expires all timers with the deadline at or before the given time.
+     * @returns the number of expired timers.
+     */
+    size_t advance(uint64_t time);
+
+    /**
+     * Returns the time at which the wheel has to be advanced next, or never if it's empty.
+     * Timers of higher levels are cascaded at the start of their slot, so this can be earlier
+     * than the closest deadline.
+     */
+    uint64_t nextExpiration() const;
+
+    /**
+     * Whether there are no scheduled timers.
+     */
+    inline bool empty() const { return count == 0; }
+
+private:
+    uint64_t nextExpiration(size_t& level, size_t& slot) const;
+    void link(Timer* timer);
+    void unlink(Timer* timer);
+
+    uint64_t elapsed;
+    size_t count;
+    std::array<uint64_t, levels> occupied;
+    std::array<std::array<Timer*, slots>, levels> lists;
+    std::atomic<Timer*> cancelled;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_TIMERWHEEL_HPP
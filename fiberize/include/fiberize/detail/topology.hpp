@@ -0,0 +1,111 @@
+/**
+ * CPU topology discovery.
+ *
+ * @file topology.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_TOPOLOGY_HPP
+#define FIBERIZE_DETAIL_TOPOLOGY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * Location of a logical CPU.
+ */
+struct CpuLocation {
+    /**
+     * Logical CPU number, as used by sched_setaffinity.
+     */
+    uint32_t cpu;
+
+    /**
+     * Physical core, unique within the package.
+     */
+    uint32_t core;
+
+    /**
+     * Physical package (socket).
+     */
+    uint32_t package;
+
+    /**
+     * NUMA node.
+     */
+    uint32_t node;
+};
+
+/**
+ * How close two CPUs are, from the closest to the most distant. The NUMA node decides before the
+ * package, because a package can be split into several nodes (sub-NUMA clustering), so CPUs of
+ * one package on different nodes are Remote.
+ */
+enum class Distance : uint8_t {
+    SameCore = 0,
+    SamePackage = 1,
+    SameNode = 2,
+    Remote = 3
+};
+
+constexpr size_t distanceLevels = 4;
+
+/**
+ * Returns the distance between two CPUs.
+ */
+Distance distance(const CpuLocation& a, const CpuLocation& b);
+
+/**
+ * Groups the other locations by their distance from the location at the given index.
+ * @returns indices of the locations at every distance, in their original order.
+ */
+std::array<std::vector<size_t>, distanceLevels> neighbours(const std::vector<CpuLocation>& locations, size_t self);
+
+/**
+ * Logical CPUs this process may run on.
+ */
+class Topology {
+public:
+    /**
+     * Reads the topology from sysfs, restricted to the CPUs in the affinity mask of the process.
+     * If sysfs is not available every CPU is assumed to be a separate core of one package.
+     */
+    static Topology detect();
+
+    /**
+     * Reads the topology of the given CPUs from a directory laid out like /sys/devices/system/cpu.
+     * CPUs missing from it are assumed to be separate cores of package 0 on node 0. If no CPUs are
+     * given the ones found in the directory are used.
+     */
+    static Topology read(const std::string& root, const std::vector<uint32_t>& allowed);
+
+    /**
+     * The CPUs ordered so that the first ones cover every physical core once, grouped by node
+     * and package. Second hardware threads of the cores follow in the same order.
+     */
+    inline const std::vector<CpuLocation>& cpus() const { return cpus_; }
+
+    /**
+     * Returns the number of NUMA nodes, that is the highest node number plus one.
+     */
+    uint32_t nodes() const;
+
+private:
+    std::vector<CpuLocation> cpus_;
+};
+
+/**
+ * Pins the calling thread to the given CPU.
+ * @returns whether the affinity was changed.
+ */
+bool pinThisThread(uint32_t cpu);
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_TOPOLOGY_HPP
@@ -0,0 +1,166 @@
+/**
+ * Lock-free work stealing deque.
+ *
+ * @file workstealingdeque.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_DETAIL_WORKSTEALINGDEQUE_HPP
+#define FIBERIZE_DETAIL_WORKSTEALINGDEQUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace fiberize {
+namespace detail {
+
+/**
+ * Chase-Lev work stealing deque of pointers.
+ *
+ * The owner thread pushes and pops at the bottom, other threads steal from the top. The memory
+ * orderings follow Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for
+ * Weak Memory Models" (PPoPP 2013).
+ *
+ * The circular buffer grows when it becomes full. Old buffers are kept until the deque is
+ * destroyed, because a thief could still be reading from them.
+ */
+template <typename A>
+class WorkStealingDeque {
+    static_assert(std::is_pointer<A>::value, "WorkStealingDeque can only store pointers.");
+
+public:
+    /**
+     * Creates an empty deque. The capacity must be a power of two.
+     */
+    explicit WorkStealingDeque(size_t capacity = 256)
+        : top(0), bottom(0) {
+        garbage.emplace_back(new Array(capacity));
+        array.store(garbage.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator = (const WorkStealingDeque&) = delete;
+
+    /**
+     * Pushes a value at the bottom.
+     * @warning Can be only called by the owner.
+     */
+    void push(A value) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+
+        if (b - t > int64_t(a->capacity()) - 1) {
+            garbage.emplace_back(a->grow(b, t));
+            a = garbage.back().get();
+            array.store(a, std::memory_order_release);
+        }
+
+        a->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Pops a value from the bottom.
+     * @returns the value or nullptr if the deque was empty.
+     * @warning Can be only called by the owner.
+     */
+    A pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t <= b) {
+            A value = a->get(b);
+            if (t == b) {
+                // The last element, race against the thieves.
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    value = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return value;
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    /**
+     * Steals a value from the top.
+     * @returns the value or nullptr if the deque was empty or we lost a race.
+     * @note Thread-safe.
+     */
+    A steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t < b) {
+            Array* a = array.load(std::memory_order_acquire);
+            A value = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return value;
+        } else {
+            return nullptr;
+        }
+    }
+
+    /**
+     * Whether the deque is empty.
+     * @note The result can be outdated when other threads access the deque.
+     */
+    bool empty() const {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+private:
+    struct Array {
+        explicit Array(size_t capacity)
+            : mask(capacity - 1), buffer(new std::atomic<A>[capacity]) {}
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+
+        A get(int64_t index) const {
+            return buffer[size_t(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, A value) {
+            buffer[size_t(index) & mask].store(value, std::memory_order_relaxed);
+        }
+
+        Array* grow(int64_t bottom, int64_t top) const {
+            Array* bigger = new Array(capacity() * 2);
+            for (int64_t i = top; i < bottom; ++i)
+                bigger->put(i, get(i));
+            return bigger;
+        }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<A>[]> buffer;
+    };
+
+    /**
+     * Top and bottom are kept on separate cache lines, as they are written by different threads.
+     * We pad instead of using alignas, because operator new doesn't respect extended alignment.
+     */
+    std::atomic<int64_t> top;
+    char padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> bottom;
+    std::atomic<Array*> array;
+    std::vector<std::unique_ptr<Array>> garbage;
+};
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_DETAIL_WORKSTEALINGDEQUE_HPP
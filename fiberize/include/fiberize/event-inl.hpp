@@ -26,12 +26,30 @@ A Event<A>::await() const {
 template <>
 void Event<void>::await() const;
 
+template <typename A>
+typename detail::Timed<A>::type Event<A>::awaitUntil(std::chrono::steady_clock::time_point deadline) const {
+    bool condition = false;
+    boost::optional<A> result;
+
+    HandlerRef handler = bind([&] (const A& value) {
+        condition = true;
+        result = value;
+        handler.release();
+    });
+
+    context::processUntil(condition, deadline);
+    return result;
+}
+
+template <>
+bool Event<void>::awaitUntil(std::chrono::steady_clock::time_point deadline) const;
+
 template <typename A>
 template <typename... Args>
 HandlerRef Event<A>::bind(Args&&... args) const {
-    std::unique_ptr<detail::Handler> handler(
-        new detail::TypedHandler<A>(std::forward<Args>(args...)...));
-    return context::detail::bind(path(), std::move(handler));
+    detail::HandlerPtr handler = detail::makeHandler<detail::TypedHandler<A>>(
+        context::detail::handlerArena(), std::forward<Args>(args)...);
+    return context::detail::bind(id(), std::move(handler));
 }
 
 } // namespace fiberize
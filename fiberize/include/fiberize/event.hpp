@@ -1,9 +1,13 @@
 #ifndef FIBERIZE_EVENT_HPP
 #define FIBERIZE_EVENT_HPP
 
+#include <chrono>
 #include <string>
 
+#include <boost/optional.hpp>
+
 #include <fiberize/path.hpp>
+#include <fiberize/eventid.hpp>
 #include <fiberize/handler.hpp>
 
 namespace fiberize {
@@ -11,23 +15,41 @@ namespace fiberize {
 template <typename A>
 class Promise;
 
+namespace detail {
+
+/**
+ * Result of an await with a timeout: the value if it arrived in time, or whether it arrived
+ * for void.
+ */
+template <typename A>
+struct Timed {
+    using type = boost::optional<A>;
+};
+
+template <>
+struct Timed<void> {
+    using type = bool;
+};
+
+} // namespace detail
+
 template <typename A>
 class Event {
 public:
     /**
      * Creates an event with a fresh unique global path.
      */
-    Event() : path_(GlobalPath(uniqueIdentGenerator.generate())) {}
+    Event() : path_(GlobalPath(uniqueIdentGenerator.generate())), id_(detail::internEvent(path_)) {}
 
     /**
      * Creates an event with the given name.
      */
-    Event(const std::string& name): path_(GlobalPath(NamedIdent(name))) {}
+    Event(const std::string& name): path_(GlobalPath(NamedIdent(name))), id_(detail::internEvent(path_)) {}
     
 private:
     struct FromPath {};
 
-    explicit Event(FromPath, const Path& path): path_(path) {}
+    explicit Event(FromPath, const Path& path): path_(path), id_(detail::internEvent(path_)) {}
 
 public:
     /**
@@ -44,32 +66,38 @@ public:
     Event& operator = (Event&&) = default;
 
     /**
-     * Compares two events by comparing their paths.
+     * Compares two events by comparing their identifiers.
      */
     bool operator == (const Event& other) const {
-        return path_ == other.path_;
+        return id_ == other.id_;
     }
 
     /**
-     * Compares two events by comparing their paths.
+     * Compares two events by comparing their identifiers.
      */
     bool operator != (const Event& other) const {
-        return path_ != other.path_;
+        return id_ != other.id_;
     }
     
     /**
      * Returns the path of this event.
      */
-    Path path() const {
+    const Path& path() const {
         return path_;
     }
 
     /**
-     * Returns the hash of the path of the event.
+     * Returns the interned identifier of this event.
+     */
+    EventId id() const {
+        return id_;
+    }
+
+    /**
+     * Returns the hash of the event.
      */
     uint64_t hash() const {
-        boost::hash<Path> hasher;
-        return hasher(path_);
+        return boost::hash_value(id_);
     }
 
 private:
@@ -84,6 +112,21 @@ public:
      * Waits until an event occurs and returns its value.
      */
     A await() const;
+
+    /**
+     * Waits until an event occurs or the deadline passes. Returns the value if the event occured.
+     */
+    typename detail::Timed<A>::type awaitUntil(std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * Waits until an event occurs or the given duration passes. Returns the value if the event
+     * occured.
+     */
+    template <typename Rep, typename Period>
+    typename detail::Timed<A>::type awaitFor(const std::chrono::duration<Rep, Period>& duration) const {
+        return awaitUntil(std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+    }
     
     /**
      * Binds an event to a handler.
@@ -100,6 +143,7 @@ public:
 
 private:
     Path path_;
+    EventId id_;
 };
     
 } // namespace fiberize
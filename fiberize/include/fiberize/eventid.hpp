@@ -0,0 +1,45 @@
+/**
+ * Interned event identifiers.
+ *
+ * @file eventid.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_EVENTID_HPP
+#define FIBERIZE_EVENTID_HPP
+
+#include <cinttypes>
+
+#include <fiberize/path.hpp>
+
+namespace fiberize {
+
+/**
+ * Compact identifier of an event, used to dispatch events to handlers.
+ *
+ * Events with a unique global path use the unique token as their identifier. All other paths
+ * are interned in a global registry and get identifiers with the highest bit set.
+ */
+using EventId = uint64_t;
+
+namespace detail {
+
+/**
+ * Marks identifiers assigned by the registry.
+ */
+constexpr EventId internedEventBit = EventId(1) << 63;
+
+/**
+ * Identifier of the /dev/null path.
+ */
+constexpr EventId devNullEventId = internedEventBit;
+
+/**
+ * Returns the identifier of an event with the given path.
+ * @note Thread-safe. Takes a global lock unless the path is a unique global path.
+ */
+EventId internEvent(const Path& path);
+
+} // namespace detail
+} // namespace fiberize
+
+#endif // FIBERIZE_EVENTID_HPP
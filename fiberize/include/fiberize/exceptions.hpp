@@ -27,6 +27,17 @@ public:
     NullAwaitable(NullAwaitable&&) = default;
 };
 
+/**
+ * Thrown when sending to a full BoundedMailbox with the Fail overflow policy.
+ */
+class MailboxFull : std::runtime_error {
+public:
+    explicit MailboxFull();
+
+    MailboxFull(const MailboxFull&) = default;
+    MailboxFull(MailboxFull&&) = default;
+};
+
 } // namespace fiberize
 
 #endif // FIBERIZE_EXCEPTIONS_HPP
@@ -27,6 +27,7 @@
 #include <fiberize/builder.hpp>
 #include <fiberize/fibersystem.hpp>
 #include <fiberize/builder-inl.hpp>
+#include <fiberize/offload.hpp>
 
 #include <fiberize/io/io.hpp>
 
@@ -3,23 +3,67 @@
 
 #include <fiberize/fiberref.hpp>
 #include <fiberize/event.hpp>
+#include <fiberize/context.hpp>
+#include <fiberize/exceptions.hpp>
+#include <fiberize/detail/task.hpp>
 
 namespace fiberize {
 
+FiberRef::FiberRef(detail::Task* task)
+    : ref_(task == nullptr ? 0 : tag(task, taskTag)) {
+    grab();
+}
+
+detail::Task* FiberRef::task() const {
+    if (ref_ != 0 && (ref_ & tagMask) == taskTag) {
+        return static_cast<detail::Task*>(counted());
+    } else {
+        return nullptr;
+    }
+}
+
 template<typename A, typename... Args>
 void FiberRef::send(const Event<A>& event, Args&&... args) const {
-    if (impl_->locality() != DevNull && event.path() != Path(DevNullPath{})) {
+    if (ref_ != 0 && event.id() != detail::devNullEventId) {
         PendingEvent pendingEvent;
-        pendingEvent.path = event.path();
-        pendingEvent.data = new A(std::forward<Args>(args)...);
-        pendingEvent.freeData = [] (void* data) { delete reinterpret_cast<A*>(data); };
-        impl_->send(pendingEvent);
+        pendingEvent.id = event.id();
+        pendingEvent.emplace<A>(std::forward<Args>(args)...);
+        if ((ref_ & tagMask) == taskTag) {
+            context::detail::deliver(task(), std::move(pendingEvent));
+        } else {
+            impl()->send(std::move(pendingEvent));
+        }
     }
 }
 
 template <>
 void FiberRef::send<void>(const Event<void>& event) const;
 
+template <typename A>
+FutureRef<A>::FutureRef(detail::Future<A>* future) : FiberRef(future) {}
+
+template <typename A>
+Result<A> FutureRef<A>::await() const {
+    if (ref_ == 0) {
+        return std::make_exception_ptr(NullAwaitable{});
+    } else if ((ref_ & tagMask) == taskTag) {
+        return static_cast<detail::Future<A>*>(task())->result.await();
+    } else {
+        return static_cast<detail::FutureRefImpl<A>*>(impl())->await();
+    }
+}
+
+template <typename A>
+boost::optional<Result<A>> FutureRef<A>::awaitUntil(std::chrono::steady_clock::time_point deadline) const {
+    if (ref_ == 0) {
+        return Result<A>(std::make_exception_ptr(NullAwaitable{}));
+    } else if ((ref_ & tagMask) == taskTag) {
+        return static_cast<detail::Future<A>*>(task())->result.awaitUntil(deadline);
+    } else {
+        return static_cast<detail::FutureRefImpl<A>*>(impl())->awaitUntil(deadline);
+    }
+}
+
 } // namespace fiberize
 
 #endif // FIBERIZE_FIBERREFINL_HPP
@@ -6,7 +6,7 @@
 #include <fiberize/mailbox.hpp>
 #include <fiberize/locality.hpp>
 #include <fiberize/detail/fiberrefimpl.hpp>
-#include <fiberize/detail/devnullfiberref.hpp>
+#include <fiberize/detail/refrencecounted.hpp>
 
 namespace fiberize {
 
@@ -16,44 +16,92 @@ class Event;
 template <typename A>
 class Promise;
 
+namespace detail {
+
+class Task;
+
+template <typename A>
+class Future;
+
+} // namespace detail
+
+/**
+ * A reference to a fiber.
+ *
+ * The reference is a single tagged pointer. A null pointer points to /dev/null, a pointer
+ * without the tag points to a local task and a tagged pointer points to a FiberRefImpl. Both
+ * tasks and implementations are intrusively reference counted, so copying a reference costs
+ * one atomic increment.
+ */
 class FiberRef {
 public:
     /**
      * Creates a fiber reference pointing to /dev/null.
      */
-    FiberRef();
+    inline FiberRef() : ref_(0) {}
+
+    /**
+     * Creates a reference to a local task.
+     */
+    inline explicit FiberRef(detail::Task* task);
 
     /**
      * Creates a new fiber reference with the given implementation.
      */
-    inline FiberRef(std::shared_ptr<detail::FiberRefImpl> impl): impl_(std::move(impl)) {}
+    inline explicit FiberRef(detail::FiberRefImpl* impl)
+        : ref_(impl == nullptr ? 0 : tag(impl, implTag)) {
+        grab();
+    }
 
     /**
      * Copies a fiber reference.
      */
-    FiberRef(const FiberRef& ref) = default;
+    inline FiberRef(const FiberRef& ref) : ref_(ref.ref_) {
+        grab();
+    }
 
     /**
      * Moves a fiber reference.
      */
-    FiberRef(FiberRef&& ref) = default;
+    inline FiberRef(FiberRef&& ref) : ref_(ref.ref_) {
+        ref.ref_ = 0;
+    }
+
+    inline ~FiberRef() {
+        drop();
+    }
 
     /**
      * Copies a fiber reference.
      */
-    FiberRef& operator = (const FiberRef& ref) = default;
+    inline FiberRef& operator = (const FiberRef& ref) {
+        ref.grab();
+        drop();
+        ref_ = ref.ref_;
+        return *this;
+    }
 
     /**
      * Moves a fiber reference.
      */
-    FiberRef& operator = (FiberRef&& ref) = default;
+    inline FiberRef& operator = (FiberRef&& ref) {
+        if (this != &ref) {
+            drop();
+            ref_ = ref.ref_;
+            ref.ref_ = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * Returns the locality of this fiber.
+     */
+    Locality locality() const;
 
     /**
      * Returns the path to this fiber.
      */
-    inline Path path() const {
-        return impl_->path();
-    }
+    Path path() const;
 
     /**
      * Kills this fiber.
@@ -67,14 +115,45 @@ public:
     void send(const Event<A>& event, Args&&... args) const;
 
     /**
-     * The internal implementation.
+     * The local task or nullptr if this reference doesn't point to a local task.
+     */
+    inline detail::Task* task() const;
+
+    /**
+     * The implementation or nullptr if this reference doesn't use one.
      */
-    inline std::shared_ptr<detail::FiberRefImpl> impl() const {
-        return impl_;
+    inline detail::FiberRefImpl* impl() const {
+        if ((ref_ & tagMask) == implTag) {
+            return static_cast<detail::FiberRefImpl*>(counted());
+        } else {
+            return nullptr;
+        }
     }
 
 protected:
-    std::shared_ptr<detail::FiberRefImpl> impl_;
+    static constexpr uintptr_t taskTag = 0;
+    static constexpr uintptr_t implTag = 1;
+    static constexpr uintptr_t tagMask = 1;
+
+    static inline uintptr_t tag(detail::ReferenceCountedAtomic* counted, uintptr_t tag) {
+        return reinterpret_cast<uintptr_t>(counted) | tag;
+    }
+
+    inline detail::ReferenceCountedAtomic* counted() const {
+        return reinterpret_cast<detail::ReferenceCountedAtomic*>(ref_ & ~tagMask);
+    }
+
+    inline void grab() const {
+        if (ref_ != 0)
+            counted()->grab();
+    }
+
+    inline void drop() const {
+        if (ref_ != 0)
+            counted()->drop();
+    }
+
+    uintptr_t ref_;
 };
 
 template <typename A>
@@ -83,18 +162,17 @@ public:
     /**
      * Creates a /dev/null future.
      */
-    FutureRef()
-        : FiberRef(std::shared_ptr<detail::FiberRefImpl>(
-            std::shared_ptr<detail::FiberRefImpl>(),
-            &detail::devNullFutureRef<A>))
-        , futureImpl_(&detail::devNullFutureRef<A>)
-        {}
+    FutureRef() = default;
+
+    /**
+     * Creates a reference to a local future.
+     */
+    inline explicit FutureRef(detail::Future<A>* future);
 
     /**
      * Creates a new future reference with the given implementation.
      */
-    FutureRef(std::shared_ptr<detail::FutureRefImpl<A>> impl)
-        : FiberRef(impl), futureImpl_(impl.get()) {}
+    explicit FutureRef(detail::FutureRefImpl<A>* impl) : FiberRef(impl) {}
 
     /**
      * Copies a future reference.
@@ -119,12 +197,22 @@ public:
     /**
      * Awaits for the result of this future.
      */
-    Result<A> await() const {
-        return futureImpl_->await();
-    }
+    inline Result<A> await() const;
 
-private:
-    detail::FutureRefImpl<A>* futureImpl_;
+    /**
+     * Awaits for the result of this future until the deadline. Returns nothing on timeout.
+     */
+    inline boost::optional<Result<A>> awaitUntil(std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * Awaits for the result of this future for at most the given duration. Returns nothing on
+     * timeout.
+     */
+    template <typename Rep, typename Period>
+    boost::optional<Result<A>> awaitFor(const std::chrono::duration<Rep, Period>& duration) const {
+        return awaitUntil(std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+    }
 };
 
 } // namespace fiberize
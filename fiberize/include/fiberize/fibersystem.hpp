@@ -1,6 +1,9 @@
 #ifndef FIBERIZE_FIBERSYSTEM_HPP
 #define FIBERIZE_FIBERSYSTEM_HPP
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <utility>
 #include <type_traits>
 
@@ -10,14 +13,17 @@
 #include <fiberize/promise.hpp>
 #include <fiberize/builder.hpp>
 #include <fiberize/fiberref.hpp>
+#include <fiberize/fiberref-inl.hpp>
 #include <fiberize/scheduler.hpp>
 #include <fiberize/context.hpp>
 #include <fiberize/detail/task.hpp>
-#include <fiberize/detail/localfiberref.hpp>
-#include <fiberize/detail/devnullfiberref.hpp>
 #include <fiberize/detail/tasktraits.hpp>
 #include <fiberize/detail/runner.hpp>
 #include <fiberize/detail/singletaskscheduler.hpp>
+#include <fiberize/detail/stackpool.hpp>
+#include <fiberize/detail/topology.hpp>
+#include <fiberize/detail/offloadpool.hpp>
+#include <fiberize/detail/osthreadpool.hpp>
 
 namespace fiberize {
 
@@ -36,8 +42,12 @@ public:
     
     /**
      * Starts the system with the given number of macrothreads.
+     *
+     * The schedulers are spread over the physical cores available to the process, filling one
+     * NUMA node before moving to the next. If pinThreads is true each scheduler thread is bound
+     * to its CPU, so that tasks and stacks allocated by it stay in the memory of its node.
      */
-    FiberSystem(uint32_t macrothreads);
+    FiberSystem(uint32_t macrothreads, bool pinThreads = false);
     
     /**
      * Cleans up the main fiber.
@@ -46,13 +56,13 @@ public:
     
     /**
      * Creates a new fiber builder using the given fiber instance and optionally a mailbox.
-     * By default the fiber is unnamed, not pinned and has a DequeMailbox.
+     * By default the fiber is unnamed, not pinned and has an MPSCMailbox.
      */
-    template <typename Fiber, typename MailboxType = DequeMailbox>
-    Builder<detail::FiberTraits, Fiber, DequeMailbox>
+    template <typename Fiber, typename MailboxType = MPSCMailbox>
+    Builder<detail::FiberTraits, Fiber, MailboxType>
     fiber(Fiber fiber, MailboxType mailbox = {}) {
         static_assert(std::is_move_constructible<Fiber>{}, "Fiber must be move constructible.");
-        return Builder<detail::FiberTraits, Fiber, DequeMailbox>(
+        return Builder<detail::FiberTraits, Fiber, MailboxType>(
             boost::none,
             std::move(fiber),
             std::move(mailbox),
@@ -63,13 +73,13 @@ public:
 
     /**
      * Creates a new future builder using the given future instance and optionally a mailbox.
-     * By default the future is unnamed, not pinned and has a DequeMailbox.
+     * By default the future is unnamed, not pinned and has an MPSCMailbox.
      */
-    template <typename Future, typename MailboxType = DequeMailbox>
-    Builder<detail::FutureTraits, Future, DequeMailbox>
+    template <typename Future, typename MailboxType = MPSCMailbox>
+    Builder<detail::FutureTraits, Future, MailboxType>
     future(Future future, MailboxType mailbox = {}) {
         static_assert(std::is_move_constructible<Future>{}, "Future must be move constructible.");
-        return Builder<detail::FutureTraits, Future, DequeMailbox>(
+        return Builder<detail::FutureTraits, Future, MailboxType>(
             boost::none,
             std::move(future),
             std::move(mailbox),
@@ -80,13 +90,13 @@ public:
 
     /**
      * Creates a new actor builder using the given actor instance and optionally a mailbox.
-     * By default the actor is unnamed, not pinned and has a DequeMailbox.
+     * By default the actor is unnamed, not pinned and has an MPSCMailbox.
      */
-    template <typename Actor, typename MailboxType = DequeMailbox>
-    Builder<detail::ActorTraits, Actor, DequeMailbox>
+    template <typename Actor, typename MailboxType = MPSCMailbox>
+    Builder<detail::ActorTraits, Actor, MailboxType>
     actor(Actor actor, MailboxType mailbox = {}) {
         static_assert(std::is_move_constructible<Actor>{}, "Actor must be move constructible.");
-        return Builder<detail::ActorTraits, Actor, DequeMailbox>(
+        return Builder<detail::ActorTraits, Actor, MailboxType>(
             boost::none,
             std::move(actor),
             std::move(mailbox),
@@ -110,13 +120,62 @@ public:
      */
     boost::uuids::uuid uuid() const;
 
+    /**
+     * Sets the maximum time a busy scheduler can go without checking for IO completions.
+     * Idle schedulers are woken up by IO immediately. The default is 10 milliseconds.
+     */
+    void ioPollInterval(std::chrono::nanoseconds interval);
+
+    /**
+     * Returns the maximum IO poll interval in nanoseconds.
+     */
+    inline uint64_t ioPollInterval() const { return ioPollInterval_.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets the watermarks of the per scheduler stack pools.
+     *
+     * A scheduler that has more than high unused stacks of one size moves all but low of them
+     * to a global pool. A scheduler that runs out of stacks takes up to low stacks from the
+     * global pool before allocating new ones. The global pool keeps at most high stacks of one
+     * size per scheduler and frees the rest. There is one global pool per NUMA node.
+     */
+    void stackPoolWatermarks(size_t low, size_t high);
+
+    /**
+     * Sets the maximum number of threads executing calls passed to context::offload(). The
+     * default is 64.
+     */
+    void offloadThreads(size_t maxThreads);
+
+    /**
+     * Sets how long an idle offload thread waits for a call before exiting. The default is
+     * 10 seconds.
+     */
+    void offloadIdleTimeout(std::chrono::nanoseconds timeout);
+
+    /**
+     * Returns the number of offload threads and calls.
+     */
+    OffloadStats offloadStats();
+
+    /**
+     * Sets the maximum number of parked threads kept for tasks started with Builder::osthread().
+     * The default is 16.
+     */
+    void osThreadIdleLimit(size_t maxIdle);
+
+    /**
+     * Sets how long a parked OS thread waits for a task before exiting. The default is 10 seconds.
+     */
+    void osThreadIdleTimeout(std::chrono::nanoseconds timeout);
+
     /**
      * Fiberize the current thread, enabling it to receive events.
      *
      * A thread once fiberized cannot be unfiberized. This makes the function leak some memory.
      * TODO: unfiberizing?
      */
-    template <typename MailboxType = DequeMailbox>
+    template <typename MailboxType = MPSCMailbox>
     FiberRef fiberize(MailboxType mailbox = {}) {
         auto task = new detail::Task;
         task->pin = nullptr;
@@ -133,7 +192,7 @@ public:
         auto scheduler = new detail::SingleTaskScheduler(this, seed, task);
         scheduler->makeCurrent();
 
-        return FiberRef(std::make_shared<detail::LocalFiberRef>(this, task));
+        return FiberRef(task);
     }
 
     /**
@@ -141,6 +200,16 @@ public:
      */
     inline const std::vector<detail::MultiTaskScheduler*>& schedulers() { return schedulers_; }
 
+    /**
+     * Returns the pool executing offloaded calls.
+     */
+    inline detail::OffloadPool& offloadPool() { return *offloadPool_; }
+
+    /**
+     * Returns the pool running OS thread tasks.
+     */
+    inline detail::OSThreadPool& osThreadPool() { return *osThreadPool_; }
+
 private:
     /**
      * Currently running schedulers.
@@ -157,6 +226,38 @@ private:
      */
     bool shuttingDown_;
 
+    /**
+     * Maximum IO poll interval in nanoseconds.
+     */
+    std::atomic<uint64_t> ioPollInterval_;
+
+    /**
+     * Stacks shared by the schedulers, one pool per NUMA node.
+     */
+    std::vector<std::unique_ptr<detail::GlobalStackPool>> stackPools_;
+
+    /**
+     * Number of parked schedulers.
+     */
+    std::atomic<uint32_t> sleepers_;
+
+    /**
+     * Number of schedulers that were woken up, but haven't found any work yet.
+     */
+    std::atomic<uint32_t> searching_;
+
+    /**
+     * Threads executing blocking calls for the fibers.
+     */
+    std::unique_ptr<detail::OffloadPool> offloadPool_;
+
+    /**
+     * Threads with their own schedulers, reused by OS thread tasks.
+     */
+    std::unique_ptr<detail::OSThreadPool> osThreadPool_;
+
+    friend class detail::MultiTaskScheduler;
+
     // If valgrind support is enabled we cannot use std::random_device, because valgrind 3.11.0
     // doesn't recognize the rdrand instruction used in the implementation of random_device.
 #ifdef FIBERIZE_VALGRIND
@@ -5,6 +5,10 @@
 #include <cinttypes>
 #include <utility>
 #include <functional>
+#include <memory>
+
+#include <fiberize/detail/handlerarena.hpp>
+#include <fiberize/detail/inlinefunction.hpp>
 
 namespace fiberize {
 
@@ -12,15 +16,25 @@ class HandlerRef;
     
 namespace detail {
     
+/**
+ * Size of the buffer used to store handler closures inline.
+ */
+constexpr size_t handlerInlineCapacity = 48;
+
 /**
  * A closure bound to an event.
  */
 struct Handler {
 public:
-    inline Handler(): refCount(0) {};
+    inline explicit Handler(HandlerArena* arena): refCount(0), arena(arena) {};
     virtual ~Handler() {};
 
     virtual void execute(const void* data) = 0;
+
+    /**
+     * Destroys the handler and returns its memory to the arena.
+     */
+    virtual void destroy() = 0;
     
     inline void grab() {
         ++refCount;
@@ -43,42 +57,84 @@ protected:
      * Number of handler references referencing this handler.
      */
     uint64_t refCount;
+
+    /**
+     * Arena this handler was allocated from.
+     */
+    HandlerArena* arena;
+};
+
+/**
+ * Destroys handlers allocated from an arena.
+ */
+struct HandlerDeleter {
+    inline void operator () (Handler* handler) const {
+        handler->destroy();
+    }
 };
 
+using HandlerPtr = std::unique_ptr<Handler, HandlerDeleter>;
+
+/**
+ * Allocates a handler of type H from the arena.
+ */
+template <typename H, typename... Args>
+HandlerPtr makeHandler(HandlerArena& arena, Args&&... args) {
+    void* memory = arena.allocate(sizeof(H));
+    try {
+        return HandlerPtr(new (memory) H(&arena, std::forward<Args>(args)...));
+    } catch (...) {
+        arena.deallocate(memory, sizeof(H));
+        throw;
+    }
+}
+
 template <typename A>
 class TypedHandler : public Handler {
 public:    
-    template <typename... Args>
-    explicit TypedHandler(Args&&... args) : handler(std::forward<Args>(args...)...) {}
+    template <typename F>
+    TypedHandler(HandlerArena* arena, F&& f) : Handler(arena), handler(std::forward<F>(f)) {}
 
     virtual void execute(const void* data) {
         handler(*reinterpret_cast<const A*>(data));
     }
+
+    virtual void destroy() {
+        HandlerArena* from = arena;
+        this->~TypedHandler();
+        from->deallocate(this, sizeof(TypedHandler));
+    }
     
 protected:
     virtual void release() {
-        handler = std::function<void (const A&)>();
+        handler.reset();
     }
     
-    std::function<void (const A&)> handler;
+    InlineFunction<void (const A&), handlerInlineCapacity> handler;
 };
 
 template <>
 class TypedHandler<void> : public Handler {
 public:
-    template <typename... Args>
-    explicit TypedHandler(Args&&... args) : handler(std::forward<Args>(args...)...) {}
+    template <typename F>
+    TypedHandler(HandlerArena* arena, F&& f) : Handler(arena), handler(std::forward<F>(f)) {}
 
     virtual void execute(const void*) {
         handler();
     }
 
+    virtual void destroy() {
+        HandlerArena* from = arena;
+        this->~TypedHandler();
+        from->deallocate(this, sizeof(TypedHandler));
+    }
+
 protected:
     virtual void release() {
-        handler = std::function<void ()>();
+        handler.reset();
     }
 
-    std::function<void ()> handler;
+    InlineFunction<void (), handlerInlineCapacity> handler;
 };
 
 } // namespace detail
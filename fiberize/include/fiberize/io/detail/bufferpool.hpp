@@ -0,0 +1,178 @@
+/**
+ * Per-scheduler pool of IO buffers.
+ *
+ * @file bufferpool.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_DETAIL_BUFFERPOOL_HPP
+#define FIBERIZE_IO_DETAIL_BUFFERPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+class BufferPool;
+
+constexpr size_t cacheLineSize = 64;
+
+/**
+ * Buffer size classes.
+ *
+ * Classes are powers of two, from minBufferSize up to maxBufferSize. Larger buffers are not pooled.
+ */
+struct BufferClasses {
+    static constexpr size_t minBufferSize = 256;
+    static constexpr size_t count = 9;
+    static constexpr size_t maxBufferSize = minBufferSize << (count - 1);
+
+    /**
+     * Returns the smallest class fitting a buffer of the given size, or count if it doesn't fit
+     * any class.
+     */
+    static size_t classOf(size_t size);
+
+    /**
+     * Returns the buffer size of the given class.
+     */
+    static inline size_t sizeOf(size_t sizeClass) {
+        return minBufferSize << sizeClass;
+    }
+};
+
+/**
+ * Header of a buffer. It takes a whole cache line and the data starts right after it, so the data
+ * is cache aligned and the reference count doesn't share a line with it.
+ */
+struct alignas(cacheLineSize) BufferBlock {
+    std::atomic<uint32_t> references;
+    uint32_t sizeClass;
+    size_t capacity;
+
+    /**
+     * The pool this block belongs to, nullptr if it is not pooled.
+     */
+    BufferPool* pool;
+
+    /**
+     * Next block on a free list.
+     */
+    BufferBlock* next;
+
+    /**
+     * Returns the data of this buffer.
+     */
+    inline char* data() { return reinterpret_cast<char*>(this + 1); }
+
+    /**
+     * Increases the reference count by 1.
+     * @note Thread-safe.
+     */
+    inline void grab() {
+        references.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    /**
+     * Decreases the reference count by 1. When the count goes down to 0 the block is returned to
+     * its pool.
+     * @note Thread-safe.
+     */
+    inline void drop() {
+        if (references.fetch_sub(1u, std::memory_order_release) == 1u) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            release(this);
+        }
+    }
+
+    /**
+     * Returns a block without references to its pool, or frees it if it isn't pooled.
+     */
+    static void release(BufferBlock* block);
+};
+
+static_assert(sizeof(BufferBlock) == cacheLineSize, "BufferBlock must take exactly one cache line");
+
+/**
+ * Slab allocator of buffers owned by a single scheduler.
+ *
+ * Only the thread running the scheduler allocates. Buffers can be released on any thread: the
+ * ones released on the owner go straight to its free lists, the others are pushed on a lock-free
+ * stack and picked up by the owner when it runs out of free buffers.
+ *
+ * The pool outlives its scheduler until all of its buffers are released.
+ */
+class BufferPool {
+public:
+    BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator = (const BufferPool&) = delete;
+
+    /**
+     * Returns a buffer with a single reference, fitting at least the given number of bytes.
+     * @warning Only the owner thread can allocate.
+     */
+    BufferBlock* allocate(size_t size);
+
+    /**
+     * Allocates a buffer that doesn't belong to any pool.
+     */
+    static BufferBlock* allocateUnpooled(size_t size);
+
+    /**
+     * Called by the owner when it is destroyed. The pool frees its memory after the last buffer
+     * is released.
+     */
+    void detach();
+
+private:
+    ~BufferPool();
+
+    /**
+     * Puts a released block back on a free list.
+     * @note Thread-safe.
+     */
+    void recycle(BufferBlock* block);
+
+    /**
+     * Moves the blocks released by other threads to the free lists.
+     */
+    void collect();
+
+    /**
+     * Allocates a new slab of the given class.
+     */
+    void refill(size_t sizeClass);
+
+    /**
+     * Drops a reference to the pool, deleting it if this was the last one.
+     */
+    void drop();
+
+    /**
+     * One reference for every allocated block and one for the owner.
+     */
+    std::atomic<size_t> references;
+    std::atomic<bool> detached;
+    std::atomic<BufferBlock*> returned;
+    BufferBlock* freeLists[BufferClasses::count];
+    std::vector<void*> slabs;
+
+    /**
+     * The thread that allocates from this pool, set by the first refill.
+     */
+    std::atomic<std::thread::id> owner;
+
+    friend struct BufferBlock;
+};
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_DETAIL_BUFFERPOOL_HPP
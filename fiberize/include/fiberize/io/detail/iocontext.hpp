@@ -7,9 +7,14 @@
 #ifndef FIBERIZE_IO_DETAIL_IOCONTEXT_HPP
 #define FIBERIZE_IO_DETAIL_IOCONTEXT_HPP
 
+#include <memory>
+
 #include <uv.h>
 
 #include <fiberize/fiberref.hpp>
+#include <fiberize/io/detail/bufferpool.hpp>
+#include <fiberize/io/detail/poller.hpp>
+#include <fiberize/io/detail/uring.hpp>
 
 namespace fiberize {
 namespace io {
@@ -27,18 +32,56 @@ public:
     bool poll();
 
     /**
-     * Run the event loop, not more often then some predefined time.
+     * Run the event loop if there are pending operations and enough time has passed since the
+     * last run. The interval adapts to the load: it shrinks when polls deliver completions and
+     * grows up to the given maximum (in nanoseconds) when they don't.
+     */
+    void throttledPoll(uint64_t maxInterval);
+
+    /**
+     * Whether there are any active handles or requests.
      */
-    void throttledPoll();
+    bool active();
+
+    /**
+     * Records that an IO operation completed. Called by the libuv callbacks.
+     */
+    inline void recordCompletion() { completions += 1; }
 
     /**
      * Returns the libuv loop associated with this IO context.
      */
     uv_loop_t* loop();
 
+    /**
+     * Returns the readiness poller of this loop.
+     */
+    inline Poller& poller() { return poller_; }
+
+    /**
+     * Returns the buffer pool of this scheduler.
+     */
+    inline BufferPool& bufferPool() { return *bufferPool_; }
+
+#ifdef FIBERIZE_IO_URING
+    /**
+     * Returns the io_uring instance of this loop, creating it on first use. Returns nullptr if
+     * io_uring is not available, the caller should fall back to libuv.
+     */
+    Ring* ring();
+#endif
+
 private:
     uv_loop_t loop_;
+    Poller poller_;
+    BufferPool* bufferPool_;
+#ifdef FIBERIZE_IO_URING
+    std::unique_ptr<Ring> ring_;
+    bool ringUnavailable_;
+#endif
     uint64_t lastRun;
+    uint64_t interval;
+    uint64_t completions;
 };
 
 } // namespace detail
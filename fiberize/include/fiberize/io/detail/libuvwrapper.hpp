@@ -86,6 +86,7 @@ struct AwaitRequestEnv : public fiberize::detail::ReferenceCountedAtomic {
          *       happens after shutdown. This should be fixed for the graceful shutdown patch.
          */
         SwapScheduler swapScheduler(scheduler);
+        scheduler->ioContext().recordCompletion();
 
         /**
          * Set the condition to true and reschedule the fiber, if necesssary.
@@ -128,6 +129,7 @@ struct AwaitHandleEnv : public fiberize::detail::ReferenceCounted {
          * @todo what if the scheduler is destroyed?
          */
         SwapScheduler swapScheduler(scheduler);
+        scheduler->ioContext().recordCompletion();
 
         /**
          * Set the condition to true and reschedule the fiber, if necesssary.
@@ -207,6 +209,7 @@ struct AsyncRequestEnv : public fiberize::detail::ReferenceCountedAtomic {
          * @todo what if the scheduler is destroyed?
          */
         SwapScheduler swapScheduler(scheduler);
+        scheduler->ioContext().recordCompletion();
 
         /**
          * Send the result as an event.
@@ -247,6 +250,7 @@ struct AsyncHandleEnv : public fiberize::detail::ReferenceCounted {
          * @todo what if the scheduler is destroyed?
          */
         SwapScheduler swapScheduler(scheduler);
+        scheduler->ioContext().recordCompletion();
 
         /**
          * Send the result as an event.
@@ -0,0 +1,162 @@
+/**
+ * Operations on nonblocking file descriptors.
+ *
+ * @file nonblocking.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_DETAIL_NONBLOCKING_HPP
+#define FIBERIZE_IO_DETAIL_NONBLOCKING_HPP
+
+#include <cerrno>
+#include <system_error>
+
+#include <sys/types.h>
+
+#include <fiberize/context.hpp>
+#include <fiberize/scheduler.hpp>
+#include <fiberize/event-inl.hpp>
+#include <fiberize/fiberref-inl.hpp>
+#include <fiberize/io/mode.hpp>
+#include <fiberize/io/detail/poller.hpp>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+/**
+ * Returns the negated errno, with EWOULDBLOCK reported as EAGAIN.
+ */
+inline ssize_t lastError() {
+    return errno == EWOULDBLOCK ? -EAGAIN : -errno;
+}
+
+/**
+ * Converts the result of an operation to a value, throwing if it's an error.
+ */
+template <typename Value>
+struct Completion {
+    static Value value(ssize_t result) {
+        if (result < 0)
+            throw std::system_error(int(-result), std::system_category());
+        return Value(result);
+    }
+
+    static void send(const FiberRef& self, const Event<Result<Value>>& event, ssize_t result) {
+        if (result < 0) {
+            self.send(event, std::make_exception_ptr(std::system_error(int(-result), std::system_category())));
+        } else {
+            self.send(event, Value(result));
+        }
+    }
+};
+
+template <>
+struct Completion<void> {
+    static void value(ssize_t result) {
+        if (result < 0)
+            throw std::system_error(int(-result), std::system_category());
+    }
+
+    static void send(const FiberRef& self, const Event<Result<void>>& event, ssize_t result) {
+        if (result < 0) {
+            self.send(event, std::make_exception_ptr(std::system_error(int(-result), std::system_category())));
+        } else {
+            self.send(event);
+        }
+    }
+};
+
+/**
+ * An Async mode operation, finished by the event loop that started it.
+ */
+template <typename Value, typename Operation>
+struct AsyncOperation : public PollWaiter {
+    AsyncOperation(Operation operation)
+        : operation(std::move(operation))
+        , self(context::self())
+        , poller(&Scheduler::current()->ioContext().poller()) {
+        ready = callback;
+    }
+
+    /**
+     * Tries to finish the operation, waits for the descriptor if it would block. Deletes this
+     * object when done.
+     */
+    void attempt() {
+        ssize_t result = operation();
+        if (result == -EAGAIN) {
+            try {
+                events = operation.events;
+                poller->add(operation.fd, this);
+                return;
+            } catch (const std::system_error& error) {
+                result = -error.code().value();
+            }
+        }
+
+        Completion<Value>::send(self, event, result);
+        delete this;
+    }
+
+    static void callback(PollWaiter* waiter, int status) {
+        auto self = static_cast<AsyncOperation*>(waiter);
+        if (status < 0) {
+            Completion<Value>::send(self->self, self->event, status);
+            delete self;
+        } else {
+            self->attempt();
+        }
+    }
+
+    Operation operation;
+    FiberRef self;
+    Event<Result<Value>> event;
+    Poller* poller;
+};
+
+template <typename Value, typename Operation>
+Value runNonblocking(Block, Operation operation) {
+    for (;;) {
+        ssize_t result = operation();
+        if (result != -EAGAIN)
+            return Completion<Value>::value(result);
+        blockReady(operation.fd, operation.events);
+    }
+}
+
+template <typename Value, typename Operation>
+Value runNonblocking(Await, Operation operation) {
+    for (;;) {
+        ssize_t result = operation();
+        if (result != -EAGAIN)
+            return Completion<Value>::value(result);
+        awaitReady(operation.fd, operation.events);
+    }
+}
+
+template <typename Value, typename Operation>
+Event<Result<Value>> runNonblocking(Async, Operation operation) {
+    auto async = new AsyncOperation<Value, Operation>(std::move(operation));
+    Event<Result<Value>> event = async->event;
+    async->attempt();
+    return event;
+}
+
+/**
+ * Runs an operation on a nonblocking descriptor in the given mode.
+ *
+ * The operation is a functor with the members fd and events. Calling it returns a nonnegative
+ * result when done, -EAGAIN if it has to wait until the descriptor is ready for the events and
+ * another negative errno on failure. It's called again after the descriptor becomes ready, so
+ * it must keep its progress.
+ */
+template <typename Value, typename Mode, typename Operation>
+IOResult<Value, Mode> runNonblocking(Operation operation) {
+    return runNonblocking<Value>(Mode(), std::move(operation));
+}
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_DETAIL_NONBLOCKING_HPP
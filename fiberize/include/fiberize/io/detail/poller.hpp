@@ -0,0 +1,100 @@
+/**
+ * Readiness notifications for file descriptors.
+ *
+ * @file poller.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_DETAIL_POLLER_HPP
+#define FIBERIZE_IO_DETAIL_POLLER_HPP
+
+#include <unordered_map>
+
+#include <uv.h>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+class IOContext;
+
+/**
+ * Something waiting for a file descriptor to become ready.
+ */
+struct PollWaiter {
+    /**
+     * The events we are waiting for, a mask of uv_poll_event.
+     */
+    int events;
+
+    /**
+     * Called on the thread running the loop when some of the events are ready, or with a
+     * negative status when polling failed. The waiter is removed from the poller before the call
+     * and can add itself again.
+     */
+    void (*ready)(PollWaiter* waiter, int status);
+
+    PollWaiter* prev;
+    PollWaiter* next;
+};
+
+/**
+ * Watches file descriptors for the waiters of one event loop.
+ *
+ * All waiters of a descriptor share a single uv_poll_t, because libuv allows only one poll handle
+ * per descriptor in a loop. This way a fiber can read from a socket while another one writes to
+ * it. The handle is closed when the last waiter is removed, so the poller never keeps a closed
+ * descriptor registered.
+ *
+ * @warning Not thread-safe, only the thread running the loop can use it.
+ */
+class Poller {
+public:
+    explicit Poller(IOContext* context);
+
+    Poller(const Poller&) = delete;
+    Poller& operator = (const Poller&) = delete;
+
+    /**
+     * Adds a waiter for the descriptor.
+     * @throws std::system_error if the descriptor cannot be polled.
+     */
+    void add(int fd, PollWaiter* waiter);
+
+    /**
+     * Removes a waiter that didn't become ready yet.
+     */
+    void remove(int fd, PollWaiter* waiter);
+
+private:
+    struct Watch {
+        uv_poll_t handle;
+        int fd;
+        PollWaiter* waiters;
+        Poller* poller;
+    };
+
+    void update(Watch* watch);
+    static void callback(uv_poll_t* handle, int status, int events);
+
+    IOContext* context;
+    std::unordered_map<int, Watch*> watches;
+};
+
+/**
+ * Processes events until the descriptor is ready for the given events. The fiber is pinned to
+ * the scheduler for the time of the wait.
+ * @throws std::system_error if polling fails.
+ */
+void awaitReady(int fd, int events);
+
+/**
+ * Blocks the thread until the descriptor is ready for the given events.
+ * @throws std::system_error if polling fails.
+ */
+void blockReady(int fd, int events);
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_DETAIL_POLLER_HPP
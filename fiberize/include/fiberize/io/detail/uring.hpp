@@ -0,0 +1,113 @@
+/**
+ * Linux io_uring submission and completion rings.
+ *
+ * @file uring.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_DETAIL_URING_HPP
+#define FIBERIZE_IO_DETAIL_URING_HPP
+
+#ifdef FIBERIZE_IO_URING
+
+#include <cstdint>
+
+#include <uv.h>
+#include <linux/io_uring.h>
+
+#include <fiberize/io/buffer.hpp>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+class IOContext;
+
+/**
+ * An operation submitted to a ring.
+ */
+struct RingRequest {
+    /**
+     * Called on the thread running the loop with the result of the operation, a negative errno
+     * on failure. It must not queue operations on the ring.
+     */
+    void (*complete)(RingRequest* request, int result);
+};
+
+/**
+ * An io_uring instance owned by a single IO context.
+ *
+ * Operations are queued with read() and write() and handed to the kernel all at once with
+ * submit(), bypassing the libuv threadpool. The ring descriptor is watched by the loop while
+ * operations are in flight, so completions are delivered like any other libuv event.
+ *
+ * @warning Not thread-safe.
+ */
+class Ring {
+public:
+    /**
+     * Creates a ring with the given number of submission entries.
+     * @throws std::system_error if io_uring or its read and write operations are not available.
+     */
+    Ring(IOContext* context, unsigned entries);
+    ~Ring();
+
+    Ring(const Ring&) = delete;
+    Ring& operator = (const Ring&) = delete;
+
+    /**
+     * Queues a read. Submits the queued operations first if the queue is full.
+     */
+    void read(int fd, const Buffer& buffer, int64_t offset, RingRequest* request);
+
+    /**
+     * Queues a write. Submits the queued operations first if the queue is full.
+     */
+    void write(int fd, const Buffer& buffer, int64_t offset, RingRequest* request);
+
+    /**
+     * Submits the queued operations with a single system call. Operations the kernel refuses to
+     * take are completed with the error.
+     */
+    void submit();
+
+private:
+    io_uring_sqe* nextEntry();
+    void failQueued(int error);
+    void reap();
+    void updatePoll();
+    void close();
+
+    static void callback(uv_poll_t* handle, int status, int events);
+
+    IOContext* context;
+    int fd;
+    uv_poll_t* poll;
+    bool polling;
+    size_t inflight;
+    unsigned queued;
+
+    void* sqRing;
+    size_t sqRingSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned* sqArray;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+
+    void* cqRing;
+    size_t cqRingSize;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    io_uring_cqe* cqes;
+};
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_URING
+
+#endif // FIBERIZE_IO_DETAIL_URING_HPP
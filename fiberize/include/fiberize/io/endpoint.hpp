@@ -0,0 +1,89 @@
+/**
+ * Socket addresses.
+ *
+ * @file endpoint.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_ENDPOINT_HPP
+#define FIBERIZE_IO_ENDPOINT_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <sys/socket.h>
+
+namespace fiberize {
+namespace io {
+
+/**
+ * An IPv4 or IPv6 address with a port.
+ *
+ * @ingroup io
+ */
+class Endpoint {
+public:
+    /**
+     * Creates an empty endpoint, which can be filled by a receive.
+     */
+    Endpoint();
+
+    /**
+     * Parses a numeric IPv4 or IPv6 address.
+     * @throws std::system_error if the address is invalid.
+     */
+    Endpoint(const char* address, uint16_t port);
+
+    /**
+     * Returns the local endpoint of a socket.
+     *
+     * Equivalent to [getsockname (2)](http://linux.die.net/man/2/getsockname).
+     */
+    static Endpoint local(int socket);
+
+    /**
+     * Returns the address family, AF_INET or AF_INET6.
+     */
+    inline int family() const { return storage.ss_family; }
+
+    /**
+     * Returns the port.
+     */
+    uint16_t port() const;
+
+    /**
+     * Returns the address as text.
+     */
+    std::string address() const;
+
+    /**
+     * Returns the raw socket address.
+     */
+    /// @{
+    inline sockaddr* data() { return reinterpret_cast<sockaddr*>(&storage); }
+    inline const sockaddr* data() const { return reinterpret_cast<const sockaddr*>(&storage); }
+    /// @}
+
+    /**
+     * Returns the length of the socket address.
+     */
+    inline socklen_t size() const { return length; }
+
+    /**
+     * Returns the size of the storage available for the socket address.
+     */
+    static constexpr socklen_t capacity() { return sizeof(sockaddr_storage); }
+
+    /**
+     * Sets the length of the socket address, after it was written by the kernel.
+     */
+    inline void resize(socklen_t size) { length = size; }
+
+private:
+    sockaddr_storage storage;
+    socklen_t length;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_ENDPOINT_HPP
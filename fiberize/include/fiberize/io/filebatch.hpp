@@ -0,0 +1,139 @@
+/**
+ * Batched file IO.
+ *
+ * @file filebatch.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_FILEBATCH_HPP
+#define FIBERIZE_IO_FILEBATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fiberize/scopedpin.hpp>
+#include <fiberize/io/buffer.hpp>
+#include <fiberize/io/pooledbuffer.hpp>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+struct FileBatchEnv;
+
+} // namespace detail
+
+/**
+ * A batch of file reads and writes, which are submitted together and executed concurrently.
+ *
+ * Operations are queued with read() and write() and started by submit(). The fiber can then wait
+ * for all of them with awaitAll() or handle them in the order they complete with next(). A batch
+ * shares one environment and one wakeup between all of its operations, instead of paying for them
+ * on every call like io::read() and io::write().
+ *
+ * When fiberize is built with the IO_URING option the operations are submitted to the
+ * scheduler's io_uring with a single system call, bypassing the libuv threadpool. Otherwise, or if
+ * the kernel doesn't support io_uring, they are executed by the libuv threadpool.
+ *
+ * @code
+ *   FileBatch batch;
+ *   for (size_t i = 0; i < n; ++i)
+ *       batch.read(file, buffers[i], offsets[i]);
+ *   batch.submit();
+ *
+ *   size_t index;
+ *   while ((index = batch.next()) != FileBatch::none)
+ *       process(buffers[index], batch.result(index));
+ * @endcode
+ *
+ * The fiber is pinned to its scheduler as long as the batch exists. Buffers must stay alive until
+ * their operations complete, destroying the batch doesn't cancel them.
+ *
+ * @ingroup io
+ */
+class FileBatch {
+public:
+    /**
+     * Returned by next() when there is nothing more to wait for.
+     */
+    static constexpr size_t none = size_t(-1);
+
+    FileBatch();
+    ~FileBatch();
+
+    FileBatch(const FileBatch&) = delete;
+    FileBatch& operator = (const FileBatch&) = delete;
+
+    /**
+     * Queues a read from the file at the given offset. Returns the index of the operation.
+     */
+    size_t read(int fd, const Buffer& buffer, int64_t offset);
+
+    /**
+     * Queues a write to the file at the given offset. Returns the index of the operation.
+     */
+    size_t write(int fd, const Buffer& buffer, int64_t offset);
+
+    /**
+     * Queues a read into a pooled buffer, up to its length. The batch keeps a reference to the
+     * buffer until the operation completes.
+     */
+    size_t read(int fd, const PooledBuffer& buffer, int64_t offset);
+
+    /**
+     * Queues a write of a pooled buffer. The batch keeps a reference to the buffer until the
+     * operation completes.
+     */
+    size_t write(int fd, const PooledBuffer& buffer, int64_t offset);
+
+    /**
+     * Starts all queued operations.
+     */
+    void submit();
+
+    /**
+     * Waits for the next operation to complete and returns its index. Returns none if no
+     * submitted operation is left.
+     */
+    size_t next();
+
+    /**
+     * Waits until the given operation completes. It won't be returned by next().
+     */
+    void await(size_t index);
+
+    /**
+     * Waits until all submitted operations complete.
+     */
+    void awaitAll();
+
+    /**
+     * Forgets a completed operation, its index can't be used anymore. Memory is reclaimed in the
+     * order of the operations, so a long lived batch should release them roughly in order.
+     */
+    void release(size_t index);
+
+    /**
+     * Returns the number of bytes transferred by a completed operation.
+     * @throws std::system_error if the operation failed.
+     */
+    size_t result(size_t index) const;
+
+    /**
+     * Returns the number of queued operations, including the released ones.
+     */
+    size_t size() const;
+
+    /**
+     * Returns the number of submitted operations that didn't complete yet.
+     */
+    size_t pending() const;
+
+private:
+    ScopedPin pin;
+    detail::FileBatchEnv* env;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_FILEBATCH_HPP
@@ -0,0 +1,130 @@
+/**
+ * Sequential file reader with read-ahead.
+ *
+ * @file filereader.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_FILEREADER_HPP
+#define FIBERIZE_IO_FILEREADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+
+#include <fiberize/io/filebatch.hpp>
+#include <fiberize/io/pooledbuffer.hpp>
+
+namespace fiberize {
+namespace io {
+
+/**
+ * Reads a file sequentially in chunks, keeping a number of reads in flight ahead of the consumer.
+ *
+ * Chunks are pooled buffers, so they can be passed to other fibers without copying. Each chunk
+ * has the full chunk size, except for the last one.
+ *
+ * @code
+ *   FileReader reader(file);
+ *   for (const PooledBuffer& chunk : reader)
+ *       process(chunk.data(), chunk.length());
+ * @endcode
+ *
+ * A reader can only be used by the fiber that created it, which is pinned to its scheduler as long
+ * as the reader exists.
+ *
+ * @ingroup io
+ */
+class FileReader {
+public:
+    /**
+     * Default size of a chunk.
+     */
+    static constexpr size_t defaultChunkSize = 64 * 1024;
+
+    /**
+     * Default number of reads in flight.
+     */
+    static constexpr size_t defaultDepth = 4;
+
+    /**
+     * Creates a reader starting at the given offset. Nothing is read before the first chunk is
+     * requested.
+     */
+    explicit FileReader(int fd, int64_t offset = 0,
+        size_t chunkSize = defaultChunkSize, size_t depth = defaultDepth);
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator = (const FileReader&) = delete;
+
+    /**
+     * Returns the next chunk of the file, or an empty buffer at the end of the file.
+     * @throws std::system_error if a read failed.
+     */
+    PooledBuffer read();
+
+    /**
+     * Returns the offset of the next chunk returned by read().
+     */
+    inline int64_t offset() const { return offset_; }
+
+    /**
+     * An input iterator over the chunks.
+     */
+    class iterator : public std::iterator<std::input_iterator_tag, PooledBuffer> {
+    public:
+        inline iterator() : reader(nullptr) {}
+        inline explicit iterator(FileReader* reader) : reader(reader), chunk(reader->read()) {
+            if (!chunk)
+                this->reader = nullptr;
+        }
+
+        inline const PooledBuffer& operator * () const { return chunk; }
+        inline const PooledBuffer* operator -> () const { return &chunk; }
+
+        inline iterator& operator ++ () {
+            chunk = reader->read();
+            if (!chunk)
+                reader = nullptr;
+            return *this;
+        }
+
+        inline bool operator == (const iterator& other) const { return reader == other.reader; }
+        inline bool operator != (const iterator& other) const { return reader != other.reader; }
+
+    private:
+        FileReader* reader;
+        PooledBuffer chunk;
+    };
+
+    /**
+     * Starts reading the chunks.
+     */
+    inline iterator begin() { return iterator(this); }
+    inline iterator end() { return iterator(); }
+
+private:
+    /**
+     * Keeps the configured number of reads in flight.
+     */
+    void readAhead();
+
+    struct Chunk {
+        size_t index;
+        PooledBuffer buffer;
+    };
+
+    FileBatch batch;
+    std::deque<Chunk> chunks;
+    int fd;
+    int64_t offset_;
+    int64_t readOffset;
+    size_t chunkSize;
+    size_t depth;
+    bool finished;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_FILEREADER_HPP
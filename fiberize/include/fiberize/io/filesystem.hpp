@@ -14,6 +14,7 @@
 #include <fiberize/promise.hpp>
 #include <fiberize/io/mode.hpp>
 #include <fiberize/io/buffer.hpp>
+#include <fiberize/io/pooledbuffer.hpp>
 
 namespace fiberize {
 namespace io {
@@ -64,6 +65,28 @@ IOResult<ssize_t, Mode> read(int fd, const Buffer bufs[], uint nbufs, int64_t of
 template <typename Mode = Await>
 IOResult<ssize_t, Mode> write(int fd, const Buffer bufs[], uint nbufs, int64_t offset);
 
+/**
+ * Reads data from the file into a pooled buffer, up to its length.
+ *
+ * In Async mode the buffer must be kept alive until the result arrives.
+ */
+template <typename Mode = Await>
+inline IOResult<ssize_t, Mode> read(int fd, const PooledBuffer& buffer, int64_t offset) {
+    Buffer buf = buffer.buffer();
+    return read<Mode>(fd, &buf, 1, offset);
+}
+
+/**
+ * Writes the data of a pooled buffer into the file.
+ *
+ * In Async mode the buffer must be kept alive until the result arrives.
+ */
+template <typename Mode = Await>
+inline IOResult<ssize_t, Mode> write(int fd, const PooledBuffer& buffer, int64_t offset) {
+    Buffer buf = buffer.buffer();
+    return write<Mode>(fd, &buf, 1, offset);
+}
+
 /**
  * Deletes a file.
  *
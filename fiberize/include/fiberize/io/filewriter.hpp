@@ -0,0 +1,114 @@
+/**
+ * Sequential file writer with write-behind.
+ *
+ * @file filewriter.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_FILEWRITER_HPP
+#define FIBERIZE_IO_FILEWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include <fiberize/io/filebatch.hpp>
+#include <fiberize/io/pooledbuffer.hpp>
+
+namespace fiberize {
+namespace io {
+
+/**
+ * Writes a file sequentially, keeping a number of writes in flight behind the producer.
+ *
+ * Small writes are coalesced into chunks, which are written in the background once they are full.
+ * Pooled buffers can also be written directly, without copying. The producer only waits when the
+ * configured number of writes is already in flight.
+ *
+ * @code
+ *   FileWriter writer(file);
+ *   for (const std::string& line : lines)
+ *       writer.write(line.data(), line.size());
+ *   writer.flush();
+ * @endcode
+ *
+ * Errors are reported by the call that waits for the failed write, at the latest by flush().
+ * Data that wasn't flushed is lost when the writer is destroyed.
+ *
+ * A writer can only be used by the fiber that created it, which is pinned to its scheduler as long
+ * as the writer exists.
+ *
+ * @ingroup io
+ */
+class FileWriter {
+public:
+    /**
+     * Default size of a chunk.
+     */
+    static constexpr size_t defaultChunkSize = 64 * 1024;
+
+    /**
+     * Default number of writes in flight.
+     */
+    static constexpr size_t defaultDepth = 4;
+
+    /**
+     * Creates a writer starting at the given offset.
+     */
+    explicit FileWriter(int fd, int64_t offset = 0,
+        size_t chunkSize = defaultChunkSize, size_t depth = defaultDepth);
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator = (const FileWriter&) = delete;
+
+    /**
+     * Appends data to the current chunk, writing it when it's full.
+     * @throws std::system_error if an earlier write failed.
+     */
+    void write(const char* data, size_t length);
+
+    /**
+     * Writes a pooled buffer without copying it, after the data appended so far.
+     * @throws std::system_error if an earlier write failed.
+     */
+    void write(const PooledBuffer& buffer);
+
+    /**
+     * Writes the current chunk and waits until all writes complete.
+     * @throws std::system_error if a write failed.
+     */
+    void flush();
+
+    /**
+     * Returns the offset at which the next data will be written.
+     */
+    inline int64_t offset() const { return offset_ + int64_t(current.length()); }
+
+private:
+    /**
+     * Starts writing a buffer, waiting for the oldest write if too many are in flight.
+     */
+    void submit(const PooledBuffer& buffer);
+
+    /**
+     * Waits for the oldest write and checks its result.
+     */
+    void retire();
+
+    struct Write {
+        size_t index;
+        size_t length;
+    };
+
+    FileBatch batch;
+    std::deque<Write> inflight;
+    PooledBuffer current;
+    int fd;
+    int64_t offset_;
+    size_t chunkSize;
+    size_t depth;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_FILEWRITER_HPP
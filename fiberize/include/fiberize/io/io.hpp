@@ -29,7 +29,15 @@
  */
 
 #include <fiberize/io/mode.hpp>
+#include <fiberize/io/pooledbuffer.hpp>
 #include <fiberize/io/filesystem.hpp>
+#include <fiberize/io/filebatch.hpp>
+#include <fiberize/io/filereader.hpp>
+#include <fiberize/io/filewriter.hpp>
+#include <fiberize/io/mappedfile.hpp>
 #include <fiberize/io/sleep.hpp>
+#include <fiberize/io/endpoint.hpp>
+#include <fiberize/io/tcp.hpp>
+#include <fiberize/io/udp.hpp>
 
 #endif // FIBERIZE_IO_IO_HPP
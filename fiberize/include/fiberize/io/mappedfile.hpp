@@ -0,0 +1,192 @@
+/**
+ * Memory mapped files.
+ *
+ * @file mappedfile.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_MAPPEDFILE_HPP
+#define FIBERIZE_IO_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fiberize/io/mode.hpp>
+#include <fiberize/io/buffer.hpp>
+#include <fiberize/detail/refrencecounted.hpp>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+/**
+ * A memory mapping, unmapped when the last reference is dropped.
+ */
+struct Mapping : public fiberize::detail::ReferenceCountedAtomic {
+    Mapping(void* base, size_t size) : base(base), size(size) {}
+    virtual ~Mapping();
+
+    void* base;
+    size_t size;
+};
+
+} // namespace detail
+
+/**
+ * Expected access pattern of a mapped file, passed to [madvise (2)](http://linux.die.net/man/2/madvise).
+ */
+enum class Advice {
+    Normal,
+    Sequential,
+    Random
+};
+
+/**
+ * A read-only, reference counted view of a memory mapped file.
+ *
+ * Reading a mapped file doesn't copy the data into a buffer like io::read() does. Copying a
+ * MappedFile only copies the reference, so a file or a slice of it can be sent in an event to
+ * another fiber without copying. The mapping is removed when the last view is released.
+ *
+ * A fiber touching a page that isn't in memory stalls the whole scheduler thread until the page
+ * is read from the disk. To avoid this, prefault() the part of the file before reading it: in
+ * Await and Async modes the pages are brought in by the libuv threadpool.
+ *
+ * @code
+ *   MappedFile file(fd);
+ *   MappedFile header = file.slice(0, 4096);
+ *   header.prefault();
+ *   parse(header.data(), header.length());
+ * @endcode
+ *
+ * @warning Like with any mapping, truncating the file while it's mapped raises SIGBUS when the
+ *          pages past the end are accessed.
+ *
+ * @ingroup io
+ */
+class MappedFile {
+public:
+    /**
+     * Creates an empty view.
+     */
+    inline MappedFile() : mapping(nullptr), data_(nullptr), length_(0) {}
+
+    /**
+     * Maps the whole file. An empty file gives an empty view.
+     * @throws std::system_error if the file can't be mapped.
+     */
+    explicit MappedFile(int fd, Advice advice = Advice::Sequential);
+
+    /**
+     * Maps a region of the file. The offset doesn't have to be page aligned.
+     * @throws std::system_error if the file can't be mapped, with EINVAL if the region doesn't
+     *         lie within the file.
+     */
+    MappedFile(int fd, int64_t offset, size_t length, Advice advice = Advice::Sequential);
+
+    /**
+     * Copies the reference, without copying any data.
+     */
+    /// @{
+    inline MappedFile(const MappedFile& other)
+        : mapping(other.mapping), data_(other.data_), length_(other.length_) {
+        if (mapping != nullptr)
+            mapping->grab();
+    }
+
+    inline MappedFile& operator = (const MappedFile& other) {
+        if (other.mapping != nullptr)
+            other.mapping->grab();
+        if (mapping != nullptr)
+            mapping->drop();
+        mapping = other.mapping;
+        data_ = other.data_;
+        length_ = other.length_;
+        return *this;
+    }
+    /// @}
+
+    /**
+     * Moves the reference.
+     */
+    /// @{
+    inline MappedFile(MappedFile&& other) : mapping(other.mapping), data_(other.data_), length_(other.length_) {
+        other.mapping = nullptr;
+        other.data_ = nullptr;
+        other.length_ = 0;
+    }
+
+    inline MappedFile& operator = (MappedFile&& other) {
+        if (this != &other) {
+            if (mapping != nullptr)
+                mapping->drop();
+            mapping = other.mapping;
+            data_ = other.data_;
+            length_ = other.length_;
+            other.mapping = nullptr;
+            other.data_ = nullptr;
+            other.length_ = 0;
+        }
+        return *this;
+    }
+    /// @}
+
+    /**
+     * Releases the reference.
+     */
+    inline ~MappedFile() {
+        if (mapping != nullptr)
+            mapping->drop();
+    }
+
+    /**
+     * Returns the pointer to the mapped data.
+     */
+    inline const char* data() const { return data_; }
+
+    /**
+     * Returns the length of this view.
+     */
+    inline size_t length() const { return length_; }
+
+    /**
+     * Returns a view of a part of this view, sharing the mapping.
+     */
+    MappedFile slice(size_t offset, size_t length) const;
+
+    /**
+     * Returns a Buffer pointing at the data, valid as long as this view is alive. The buffer can
+     * only be read from, for example by io::write().
+     * @throws std::system_error with EOVERFLOW if the view is 4 GiB or longer, a Buffer can't
+     *         describe it. Use slice() to split it.
+     */
+    Buffer buffer() const;
+
+    /**
+     * Changes the expected access pattern of the pages in this view.
+     */
+    void advise(Advice advice) const;
+
+    /**
+     * Brings all pages of this view into memory, so reading them won't fault.
+     *
+     * In Await and Async modes the pages are touched by the libuv threadpool, while the scheduler
+     * keeps running other fibers. Block mode touches them on the current thread.
+     */
+    template <typename Mode = Await>
+    IOResult<void, Mode> prefault() const;
+
+    /**
+     * Whether this view refers to a mapping.
+     */
+    inline explicit operator bool () const { return mapping != nullptr; }
+
+private:
+    detail::Mapping* mapping;
+    const char* data_;
+    size_t length_;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_MAPPEDFILE_HPP
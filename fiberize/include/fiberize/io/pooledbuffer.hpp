@@ -0,0 +1,140 @@
+/**
+ * Reference counted buffers allocated from the scheduler's pool.
+ *
+ * @file pooledbuffer.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_POOLEDBUFFER_HPP
+#define FIBERIZE_IO_POOLEDBUFFER_HPP
+
+#include <cassert>
+#include <cstddef>
+
+#include <fiberize/io/buffer.hpp>
+#include <fiberize/io/detail/bufferpool.hpp>
+
+namespace fiberize {
+namespace io {
+
+/**
+ * A reference counted, cache aligned buffer.
+ *
+ * Buffers are allocated from a slab pool owned by the current scheduler, so allocating one is
+ * usually just a pop from a free list. Copying a PooledBuffer only copies the reference: it can be
+ * sent in an event to another fiber without copying the data. When the last reference is released
+ * the memory goes back to the pool it came from, even if this happens on another scheduler.
+ *
+ * Every reference has its own length, which can be changed up to the capacity.
+ *
+ * @code
+ *   PooledBuffer buffer(4096);
+ *   buffer.resize(io::read(file, buffer, offset));
+ *   consumer.send(logChunk, buffer);
+ * @endcode
+ *
+ * @ingroup io
+ */
+class PooledBuffer {
+public:
+    /**
+     * Creates an empty buffer.
+     */
+    inline PooledBuffer() : block(nullptr), length_(0) {}
+
+    /**
+     * Allocates a buffer of the given length. Outside of a scheduler the buffer is not pooled.
+     */
+    explicit PooledBuffer(size_t length);
+
+    /**
+     * Copies the reference, without copying any data.
+     */
+    /// @{
+    inline PooledBuffer(const PooledBuffer& other) : block(other.block), length_(other.length_) {
+        if (block != nullptr)
+            block->grab();
+    }
+
+    inline PooledBuffer& operator = (const PooledBuffer& other) {
+        if (other.block != nullptr)
+            other.block->grab();
+        if (block != nullptr)
+            block->drop();
+        block = other.block;
+        length_ = other.length_;
+        return *this;
+    }
+    /// @}
+
+    /**
+     * Moves the reference.
+     */
+    /// @{
+    inline PooledBuffer(PooledBuffer&& other) : block(other.block), length_(other.length_) {
+        other.block = nullptr;
+        other.length_ = 0;
+    }
+
+    inline PooledBuffer& operator = (PooledBuffer&& other) {
+        if (this != &other) {
+            if (block != nullptr)
+                block->drop();
+            block = other.block;
+            length_ = other.length_;
+            other.block = nullptr;
+            other.length_ = 0;
+        }
+        return *this;
+    }
+    /// @}
+
+    /**
+     * Releases the reference.
+     */
+    inline ~PooledBuffer() {
+        if (block != nullptr)
+            block->drop();
+    }
+
+    /**
+     * Returns the pointer to the buffer data.
+     */
+    inline char* data() const { return block != nullptr ? block->data() : nullptr; }
+
+    /**
+     * Returns the length of this buffer.
+     */
+    inline size_t length() const { return length_; }
+
+    /**
+     * Returns the size of the allocated memory.
+     */
+    inline size_t capacity() const { return block != nullptr ? block->capacity : 0; }
+
+    /**
+     * Changes the length of this reference. The length can't exceed the capacity.
+     */
+    inline void resize(size_t length) {
+        assert(length <= capacity());
+        length_ = length;
+    }
+
+    /**
+     * Returns a Buffer pointing at the data, valid as long as this buffer is alive.
+     */
+    inline Buffer buffer() const { return Buffer(data(), uint(length_)); }
+
+    /**
+     * Whether this buffer holds any memory.
+     */
+    inline explicit operator bool () const { return block != nullptr; }
+
+private:
+    detail::BufferBlock* block;
+    size_t length_;
+};
+
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_POOLEDBUFFER_HPP
@@ -45,7 +45,8 @@ namespace io {
  *   });
  * @endcode
  *
- * @note Implemented using http://docs.libuv.org/en/v1.x/timer.html
+ * Await and Async timers live in a timing wheel of the scheduler that started them. A sleeping
+ * fiber is not pinned, once its timer expires it can be resumed by any scheduler.
  */
 ///@{
 
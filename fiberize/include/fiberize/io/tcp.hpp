@@ -0,0 +1,120 @@
+/**
+ * TCP sockets.
+ *
+ * @see @ref io_tcp
+ *
+ * @file tcp.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_TCP_HPP
+#define FIBERIZE_IO_TCP_HPP
+
+#include <cstdint>
+
+#include <fiberize/io/mode.hpp>
+#include <fiberize/io/buffer.hpp>
+
+namespace fiberize {
+namespace io {
+namespace tcp {
+
+/**
+ * @defgroup io_tcp TCP sockets
+ * @ingroup io
+ *
+ * TCP sockets.
+ *
+ * The @ref fiberize/io/tcp.hpp module implements TCP clients and servers. Sockets are plain
+ * nonblocking file descriptors, which can be used by any fiber on any scheduler. Operations are
+ * first attempted directly and only wait for the socket to become ready if they would block:
+ *  - in Await mode the fiber processes events and lets other fibers run until the socket is ready,
+ *  - in Block mode the thread waits with [poll (2)](http://linux.die.net/man/2/poll),
+ *  - in Async mode the operation is finished by the event loop of the current scheduler and the
+ *    result is sent to the calling fiber as an event.
+ *
+ * A simple echo server:
+ * @code
+ *   int listener = tcp::listen("127.0.0.1", 8080);
+ *   for (;;) {
+ *       int socket = tcp::accept(listener);
+ *       system->fiber([socket] () {
+ *           char data[4096];
+ *           while (size_t n = tcp::read(socket, Buffer(data, sizeof(data)))) {
+ *               tcp::write(socket, Buffer(data, n));
+ *           }
+ *           io::close(socket);
+ *       }).run();
+ *   }
+ * @endcode
+ *
+ * Sockets are closed with io::close(). One fiber can read from a socket while another one writes
+ * to it.
+ *
+ * @note Readiness is watched with http://docs.libuv.org/en/v1.x/poll.html
+ */
+///@{
+
+/**
+ * Creates a socket listening on the given IPv4 or IPv6 address. Port 0 picks a free port.
+ *
+ * Equivalent to [socket (2)](http://linux.die.net/man/2/socket), [bind (2)](http://linux.die.net/man/2/bind)
+ * and [listen (2)](http://linux.die.net/man/2/listen).
+ */
+template <typename Mode = Block>
+IOResult<int, Mode> listen(const char* address, uint16_t port, int backlog = 128);
+
+/**
+ * Accepts a connection.
+ *
+ * Equivalent to [accept (2)](http://linux.die.net/man/2/accept).
+ */
+template <typename Mode = Await>
+IOResult<int, Mode> accept(int listener);
+
+/**
+ * Connects to the given IPv4 or IPv6 address.
+ *
+ * Equivalent to [socket (2)](http://linux.die.net/man/2/socket) and
+ * [connect (2)](http://linux.die.net/man/2/connect).
+ */
+template <typename Mode = Await>
+IOResult<int, Mode> connect(const char* address, uint16_t port);
+
+/**
+ * Reads data from the socket. Returns the number of bytes read, 0 at the end of the stream.
+ *
+ * Equivalent to [recv (2)](http://linux.die.net/man/2/recv).
+ */
+template <typename Mode = Await>
+IOResult<size_t, Mode> read(int socket, const Buffer& buffer);
+
+/**
+ * Writes the whole buffer to the socket. Returns the number of bytes written.
+ *
+ * Equivalent to [send (2)](http://linux.die.net/man/2/send), repeated until all data is sent.
+ */
+template <typename Mode = Await>
+IOResult<size_t, Mode> write(int socket, const Buffer& buffer);
+
+/**
+ * Shuts down the writing side of the socket.
+ *
+ * Equivalent to [shutdown (2)](http://linux.die.net/man/2/shutdown) with SHUT_WR.
+ */
+template <typename Mode = Block>
+IOResult<void, Mode> shutdown(int socket);
+
+/**
+ * Returns the local port of a socket.
+ *
+ * Equivalent to [getsockname (2)](http://linux.die.net/man/2/getsockname).
+ */
+uint16_t localPort(int socket);
+
+///@}
+
+} // namespace tcp
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_TCP_HPP
@@ -0,0 +1,125 @@
+/**
+ * UDP sockets.
+ *
+ * @see @ref io_udp
+ *
+ * @file udp.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_IO_UDP_HPP
+#define FIBERIZE_IO_UDP_HPP
+
+#include <cstdint>
+
+#include <fiberize/io/mode.hpp>
+#include <fiberize/io/buffer.hpp>
+#include <fiberize/io/endpoint.hpp>
+
+namespace fiberize {
+namespace io {
+namespace udp {
+
+/**
+ * @defgroup io_udp UDP sockets
+ * @ingroup io
+ *
+ * UDP sockets.
+ *
+ * The @ref fiberize/io/udp.hpp module implements datagram sockets. Like TCP sockets they are
+ * nonblocking file descriptors usable from any fiber, see @ref io_tcp for how the IO modes wait.
+ *
+ * Besides single datagrams, sendmmsg() and recvmmsg() transfer many datagrams in one system
+ * call. A receiver woken up once can drain everything that arrived in the meantime:
+ * @code
+ *   Datagram datagrams[32];
+ *   // ... point each datagram at a buffer ...
+ *   for (;;) {
+ *       uint n = udp::recvmmsg(socket, datagrams, 32);
+ *       for (uint i = 0; i < n; ++i)
+ *           process(datagrams[i].bufs[0].data(), datagrams[i].length);
+ *   }
+ * @endcode
+ */
+///@{
+
+/**
+ * A datagram for sendmmsg() and recvmmsg().
+ */
+struct Datagram {
+    /**
+     * Buffers with the payload. When receiving they are filled in order.
+     */
+    const Buffer* bufs;
+    uint nbufs;
+
+    /**
+     * Destination when sending, source after receiving.
+     */
+    Endpoint peer;
+
+    /**
+     * Number of bytes sent or received.
+     */
+    size_t length;
+};
+
+/**
+ * Creates a socket bound to the given IPv4 or IPv6 address. Port 0 picks a free port.
+ *
+ * Equivalent to [socket (2)](http://linux.die.net/man/2/socket) and [bind (2)](http://linux.die.net/man/2/bind).
+ */
+template <typename Mode = Block>
+IOResult<int, Mode> bind(const char* address, uint16_t port);
+
+/**
+ * Sends a datagram gathered from multiple buffers. Returns the number of bytes sent.
+ *
+ * In Async mode the bufs array and the buffers must be kept alive until the result arrives.
+ *
+ * Equivalent to [sendmsg (2)](http://linux.die.net/man/2/sendmsg).
+ */
+template <typename Mode = Await>
+IOResult<size_t, Mode> sendto(int socket, const Buffer bufs[], uint nbufs, const Endpoint& to);
+
+/**
+ * Receives a datagram into multiple buffers. Returns the number of bytes received and stores
+ * the sender, if from is not null. A datagram larger than the buffers is truncated.
+ *
+ * In Async mode the bufs array, the buffers and from must be kept alive until the result arrives.
+ *
+ * Equivalent to [recvmsg (2)](http://linux.die.net/man/2/recvmsg).
+ */
+template <typename Mode = Await>
+IOResult<size_t, Mode> recvfrom(int socket, const Buffer bufs[], uint nbufs, Endpoint* from);
+
+/**
+ * Sends all the datagrams, with as few system calls as possible. Returns the number of datagrams
+ * sent and sets their lengths.
+ *
+ * In Async mode the datagrams, their bufs arrays and the buffers must be kept alive until the
+ * result arrives.
+ *
+ * Equivalent to [sendmmsg (2)](http://linux.die.net/man/2/sendmmsg).
+ */
+template <typename Mode = Await>
+IOResult<uint, Mode> sendmmsg(int socket, Datagram datagrams[], uint n);
+
+/**
+ * Waits for at least one datagram and receives up to n of those already queued, with as few system
+ * calls as possible. Returns the number of datagrams received and sets their lengths and senders.
+ *
+ * In Async mode the datagrams, their bufs arrays and the buffers must be kept alive until the
+ * result arrives.
+ *
+ * Equivalent to [recvmmsg (2)](http://linux.die.net/man/2/recvmmsg).
+ */
+template <typename Mode = Await>
+IOResult<uint, Mode> recvmmsg(int socket, Datagram datagrams[], uint n);
+
+///@}
+
+} // namespace udp
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_UDP_HPP
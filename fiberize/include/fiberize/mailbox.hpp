@@ -3,6 +3,8 @@
 
 #include <atomic>
 #include <vector>
+#include <cstddef>
+#include <type_traits>
 #include <iostream>
 
 #include <boost/circular_buffer.hpp>
@@ -10,16 +12,162 @@
 #include <boost/thread.hpp>
 
 #include <fiberize/path.hpp>
+#include <fiberize/eventid.hpp>
+#include <fiberize/spinlock.hpp>
+#include <fiberize/condition.hpp>
 #include <fiberize/detail/lazydeque.hpp>
 
 namespace fiberize {
 
-struct PendingEvent {
-    Path path;
-    void* data;
-    void (*freeData)(void*);
+/**
+ * An event waiting in a mailbox, together with its payload.
+ *
+ * Payloads that fit in the inline buffer and are nothrow move constructible are stored in place,
+ * larger ones are allocated on the heap. The event owns the payload and destroys it.
+ */
+class PendingEvent {
+public:
+    /**
+     * Size of the inline buffer in bytes.
+     */
+    static constexpr size_t inlineCapacity = 48;
+
+    /**
+     * Creates an event without a payload.
+     */
+    inline PendingEvent() : id(detail::devNullEventId), ops(nullptr) {}
+
+    PendingEvent(const PendingEvent&) = delete;
+    PendingEvent& operator = (const PendingEvent&) = delete;
+
+    inline PendingEvent(PendingEvent&& other) noexcept : id(other.id), ops(nullptr) {
+        take(other);
+    }
+
+    inline PendingEvent& operator = (PendingEvent&& other) noexcept {
+        if (this != &other) {
+            reset();
+            id = other.id;
+            take(other);
+        }
+        return *this;
+    }
+
+    inline ~PendingEvent() {
+        reset();
+    }
+
+    /**
+     * Constructs a payload of type A, destroying the previous one.
+     */
+    template <typename A, typename... Args>
+    void emplace(Args&&... args) {
+        reset();
+        if (fitsInline<A>()) {
+            new (&storage.buffer) A(std::forward<Args>(args)...);
+            ops = &InlineOps<A>::ops;
+        } else {
+            storage.heap = new A(std::forward<Args>(args)...);
+            ops = &HeapOps<A>::ops;
+        }
+    }
+
+    /**
+     * Returns a pointer to the payload or nullptr if there is none.
+     */
+    inline const void* data() const {
+        if (ops == nullptr) {
+            return nullptr;
+        } else if (ops->inlined) {
+            return &storage.buffer;
+        } else {
+            return storage.heap;
+        }
+    }
+
+    /**
+     * Destroys the payload.
+     */
+    inline void reset() {
+        if (ops != nullptr) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    /**
+     * Whether a payload of type A is stored inline.
+     */
+    template <typename A>
+    static constexpr bool fitsInline() {
+        return sizeof(A) <= inlineCapacity
+            && alignof(A) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<A>::value;
+    }
+
+    /**
+     * Identifier of the event.
+     */
+    EventId id;
+
+private:
+    union Storage {
+        void* heap;
+        typename std::aligned_storage<inlineCapacity, alignof(std::max_align_t)>::type buffer;
+    };
+
+    struct Ops {
+        void (*move)(Storage& to, Storage& from);
+        void (*destroy)(Storage& storage);
+        bool inlined;
+    };
+
+    template <typename A>
+    struct InlineOps {
+        static void move(Storage& to, Storage& from) {
+            A* value = reinterpret_cast<A*>(&from.buffer);
+            new (&to.buffer) A(std::move(*value));
+            value->~A();
+        }
+
+        static void destroy(Storage& storage) {
+            reinterpret_cast<A*>(&storage.buffer)->~A();
+        }
+
+        static constexpr Ops ops = { move, destroy, true };
+    };
+
+    template <typename A>
+    struct HeapOps {
+        static void move(Storage& to, Storage& from) {
+            to.heap = from.heap;
+        }
+
+        static void destroy(Storage& storage) {
+            delete reinterpret_cast<A*>(storage.heap);
+        }
+
+        static constexpr Ops ops = { move, destroy, false };
+    };
+
+    inline void take(PendingEvent& other) noexcept {
+        if (other.ops != nullptr) {
+            other.ops->move(storage, other.storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+
+    const Ops* ops;
+    Storage storage;
 };
 
+template <typename A>
+constexpr PendingEvent::Ops PendingEvent::InlineOps<A>::ops;
+
+template <typename A>
+constexpr PendingEvent::Ops PendingEvent::HeapOps<A>::ops;
+
 class Mailbox {
 public:
     /**
@@ -29,13 +177,33 @@ public:
     
     /**
      * Tries to dequeue an event.
+     * @note Called only by the owning task, with the task lock held.
      */
     virtual bool dequeue(PendingEvent& event) = 0;
+
+    /**
+     * Dequeues up to n events into the given array.
+     * @returns the number of dequeued events.
+     * @note Called only by the owning task, with the task lock held.
+     */
+    virtual size_t dequeueBatch(PendingEvent* events, size_t n);
     
     /**
-     * Enqueues an event.
+     * Enqueues an event. If the mailbox doesn't accept the event it is left with the caller.
+     * @returns whether the mailbox was empty before the enqueue.
      */
-    virtual void enqueue(const PendingEvent& event) = 0;
+    virtual bool enqueue(PendingEvent&& event) = 0;
+
+    /**
+     * Called by the owning task after a successful dequeue or batch, once the task lock is released.
+     */
+    virtual void dequeued();
+
+    /**
+     * Whether enqueue can be called concurrently, without holding the task lock. Senders of such
+     * mailboxes take the lock only to resume the task, after an enqueue into an empty mailbox.
+     */
+    virtual bool concurrentEnqueue() const;
 
     /**
      * Whether the mailbox is empty.
@@ -52,7 +220,7 @@ class DequeMailbox : public Mailbox {
 public:
     virtual ~DequeMailbox();
     virtual bool dequeue(PendingEvent& event);
-    virtual void enqueue(const PendingEvent& event);
+    virtual bool enqueue(PendingEvent&& event);
     virtual bool empty();
     virtual void clear();
 
@@ -60,6 +228,136 @@ private:
     detail::LazyDeque<PendingEvent> pendingEvents;
 };
 
+/**
+ * Multiple producer, single consumer mailbox based on Dmitry Vyukov's intrusive queue.
+ *
+ * Enqueue is wait-free and doesn't take the task lock. Dequeue can briefly spin if a producer
+ * was preempted between publishing its node and linking it.
+ */
+class MPSCMailbox : public Mailbox {
+public:
+    MPSCMailbox();
+
+    /**
+     * Mailboxes are copied together with builders, before any event is sent. Pending events
+     * are not copied.
+     */
+    MPSCMailbox(const MPSCMailbox&);
+    MPSCMailbox(MPSCMailbox&& other);
+    virtual ~MPSCMailbox();
+    virtual bool dequeue(PendingEvent& event);
+    virtual size_t dequeueBatch(PendingEvent* events, size_t n);
+    virtual bool enqueue(PendingEvent&& event);
+    virtual bool concurrentEnqueue() const;
+    virtual bool empty();
+    virtual void clear();
+
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        PendingEvent event;
+
+        static void* operator new(size_t size);
+        static void operator delete(void* node);
+    };
+
+    /**
+     * Producers append at the head.
+     */
+    std::atomic<Node*> head;
+
+    /**
+     * Number of enqueued events. Incremented after the node is linked.
+     */
+    std::atomic<size_t> count;
+
+    /**
+     * The consumer removes from the tail. The tail node is always a dummy.
+     */
+    Node* tail;
+};
+
+/**
+ * Policy used by a BoundedMailbox when it is full and the sender cannot be suspended.
+ */
+enum class OverflowPolicy : uint8_t {
+    /**
+     * Block the sending thread until there is space.
+     */
+    Block,
+
+    /**
+     * Discard the event being sent.
+     */
+    DropNewest,
+
+    /**
+     * Discard the oldest pending event to make space.
+     */
+    DropOldest,
+
+    /**
+     * Throw MailboxFull.
+     */
+    Fail
+};
+
+/**
+ * Mailbox with a fixed capacity.
+ *
+ * When the mailbox is full a sending fiber is suspended until the receiver makes space, processing
+ * its own events in the meantime. Senders that are not fibers running on a multitasking scheduler
+ * (fiberized threads, OS thread tasks and foreign threads) use the overflow policy instead.
+ * With OverflowPolicy::Block fiberized threads are suspended like fibers and foreign threads spin.
+ *
+ * @warning Two fibers sending to each other's full mailboxes can deadlock, just as with any
+ *          other form of blocking.
+ */
+class BoundedMailbox : public Mailbox {
+public:
+    explicit BoundedMailbox(size_t capacity, OverflowPolicy policy = OverflowPolicy::Fail);
+
+    /**
+     * Mailboxes are copied together with builders, before any event is sent. Pending events
+     * are not copied.
+     */
+    BoundedMailbox(const BoundedMailbox& other);
+    BoundedMailbox(BoundedMailbox&& other);
+    virtual ~BoundedMailbox();
+
+    virtual bool dequeue(PendingEvent& event);
+    virtual size_t dequeueBatch(PendingEvent* events, size_t n);
+    virtual bool enqueue(PendingEvent&& event);
+    virtual void dequeued();
+    virtual bool concurrentEnqueue() const;
+    virtual bool empty();
+
+    /**
+     * Frees all pending events, wakes up waiting senders and drops all events sent later.
+     */
+    virtual void clear();
+
+    /**
+     * Returns the capacity of this mailbox.
+     */
+    inline size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_;
+    OverflowPolicy policy;
+
+    Spinlock spinlock;
+    boost::circular_buffer<PendingEvent> pendingEvents;
+    Condition notFull;
+    size_t waiting;
+    bool closed;
+
+    /**
+     * Number of senders that should be woken up in dequeued(), set by dequeue().
+     */
+    size_t sendersToWake;
+};
+
 } // namespace fiberize
 
 #endif // FIBER_MAILBOX_HPP
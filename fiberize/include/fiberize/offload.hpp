@@ -0,0 +1,76 @@
+/**
+ * Offloading blocking calls.
+ *
+ * @file offload.hpp
+ * @copyright 2015 Paweł Nowak
+ */
+#ifndef FIBERIZE_OFFLOAD_HPP
+#define FIBERIZE_OFFLOAD_HPP
+
+#include <utility>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
+
+#include <fiberize/result.hpp>
+#include <fiberize/detail/offloadpool.hpp>
+
+namespace fiberize {
+namespace detail {
+
+template <typename Closure, typename A>
+class OffloadClosure : public OffloadJob {
+public:
+    OffloadClosure(Closure closure) : closure(std::move(closure)) {}
+
+    void execute() override {
+        result_ = fiberize::result(closure);
+    }
+
+    boost::optional<Result<A>> result_;
+
+private:
+    Closure closure;
+};
+
+} // namespace detail
+
+namespace context {
+namespace detail {
+
+/**
+ * Submits the job to the offload pool of the system and processes events until it completes.
+ */
+void offload(fiberize::detail::OffloadJob* job);
+
+} // namespace detail
+
+/**
+ * Executes a blocking call on the offload pool of the system and waits for the result.
+ *
+ * Only the current fiber waits, processing events in the meantime, while the scheduler runs other
+ * fibers. Use it for libraries that block the thread, instead of calling them directly or
+ * spawning an OS thread fiber. The fiber is pinned to its scheduler until the call completes.
+ *
+ * @code
+ *   Result<Row> row = context::offload([&] () { return database.query(id); });
+ *   process(row.get());
+ * @endcode
+ *
+ * The closure runs on a plain thread, so it can't use fiber functions like context::self().
+ * Exceptions thrown by the closure are returned in the result.
+ *
+ * @ingroup context
+ */
+template <typename Closure, typename A = decltype(std::declval<Closure&>()())>
+Result<A> offload(Closure closure) {
+    boost::intrusive_ptr<fiberize::detail::OffloadClosure<Closure, A>> job(
+        new fiberize::detail::OffloadClosure<Closure, A>(std::move(closure)));
+    detail::offload(job.get());
+    return std::move(*job->result_);
+}
+
+} // namespace context
+} // namespace fiberize
+
+#endif // FIBERIZE_OFFLOAD_HPP
@@ -28,12 +28,17 @@ struct Box {
         return value;
     }
 
+    boost::optional<A> timed() const {
+        return value;
+    }
+
     A value;
 };
 
 template <>
 struct Box<void> {
     void copy() const {}
+    bool timed() const { return true; }
 };
 
 } // namespace detail
@@ -102,6 +107,28 @@ public:
         return result.get().copy();
     }
 
+    /**
+     * Awaits until the promise is complete or the deadline passes. Returns the value if the
+     * promise was completed.
+     */
+    typename detail::Timed<A>::type awaitUntil(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<Spinlock> lock(spinlock);
+        if (!result && !completed.awaitUntil(lock, deadline)) {
+            return {};
+        }
+        return result.get().timed();
+    }
+
+    /**
+     * Awaits until the promise is complete or the given duration passes. Returns the value if
+     * the promise was completed.
+     */
+    template <typename Rep, typename Period>
+    typename detail::Timed<A>::type awaitFor(const std::chrono::duration<Rep, Period>& duration) {
+        return awaitUntil(std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+    }
+
 private:
     HandlerRef handler;
     Condition completed;
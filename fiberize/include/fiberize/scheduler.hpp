@@ -8,6 +8,7 @@
 #define FIBERIZE_SCHEDULER_HPP
 
 #include <fiberize/detail/task.hpp>
+#include <fiberize/detail/timerwheel.hpp>
 #include <fiberize/io/detail/iocontext.hpp>
 
 namespace fiberize {
@@ -69,6 +70,20 @@ public:
      */
     inline io::detail::IOContext& ioContext() { return ioContext_; }
 
+    /**
+     * Returns the timers of this scheduler. Only the thread running the scheduler can use them.
+     */
+    inline detail::TimerWheel& timers() { return timers_; }
+
+    /**
+     * Removes the timers cancelled by other threads and expires the timers that are due.
+     * @returns whether any timer expired.
+     */
+    inline bool expireTimers() {
+        timers_.collectCancelled();
+        return !timers_.empty() && timers_.advance(detail::TimerWheel::now()) != 0;
+    }
+
     /**
      * Returns a random generator local to this scheduler.
      */
@@ -79,13 +94,44 @@ public:
      */
     static inline Scheduler* current() { return current_; }
 
-    static void idle(uint64_t& idleStreak);
+    /**
+     * Called when the scheduler has nothing to do. Spins for a while and then parks the thread.
+     */
+    void idle(uint64_t& idleStreak);
+
+    /**
+     * Blocks the thread until it is unparked, an IO event arrives or a timer expires.
+     * Returns immediately if canPark() returns false after the scheduler is marked as parked.
+     */
+    virtual void park();
+
+    /**
+     * Wakes up the scheduler if it is parked.
+     * @returns whether the scheduler was parked.
+     * @note Thread-safe.
+     */
+    bool unpark();
+
+    /**
+     * Marks the task as dead, frees its resources and drops its life reference.
+     * @param lock Lock on the task's spinlock, released by this function.
+     */
     static void kill(detail::Task* task, std::unique_lock<Spinlock>&& lock);
 
+protected:
+    /**
+     * Checks whether there is no more work for this scheduler. It is called after the scheduler
+     * is marked as parked, so any work submitted later will be followed by an unpark().
+     */
+    virtual bool canPark() = 0;
+
 private:
 
     FiberSystem* system_;
+    std::atomic<bool> parked_;
+    int wakeupFd_;
     io::detail::IOContext ioContext_;
+    detail::TimerWheel timers_;
     std::mt19937_64 random_;
     static thread_local Scheduler* current_;
 };
@@ -14,6 +14,16 @@ Condition::Condition()
     : released(0), nextTicket(1) {}
 
 void Condition::await(std::unique_lock<Spinlock>& lock) {
+    static const bool never = false;
+    await(lock, never);
+}
+
+bool Condition::awaitUntil(std::unique_lock<Spinlock>& lock, std::chrono::steady_clock::time_point deadline) {
+    context::detail::Timeout timeout(deadline);
+    return await(lock, timeout.expired());
+}
+
+bool Condition::await(std::unique_lock<Spinlock>& lock, const bool& expired) {
     assert(lock.owns_lock());
 
     // Append ourself to the queue.
@@ -27,7 +37,7 @@ void Condition::await(std::unique_lock<Spinlock>& lock) {
 
     try {
         // Process events when we are waiting.
-        while (released.load(std::memory_order_consume) < ticket) {
+        while (released.load(std::memory_order_consume) < ticket && !expired) {
             context::process();
 
             // The process() call will set the expected resume count. If the condition
@@ -37,8 +47,9 @@ void Condition::await(std::unique_lock<Spinlock>& lock) {
             // immediately). In this case the change to "released" will be visible after
             // exiting suspend() and the loop will end. In the third case the condition
             // arrives after we suspend, in which case we will be woken up.
+            // The same goes for the timeout.
 
-            if (released.load(std::memory_order_consume) >= ticket) {
+            if (released.load(std::memory_order_consume) >= ticket || expired) {
                 break;
             }
 
@@ -47,12 +58,8 @@ void Condition::await(std::unique_lock<Spinlock>& lock) {
     } catch (...) {
         // Something (probably a handler) threw an exception. Ensure that we don't eat the signal.
         lock.lock();
-        uint64_t rel = released.load(std::memory_order_relaxed);
-        if (rel < ticket) {
-            // Set our task to nullptr to signal that we don't want the lock anymore.
-            // We can calculate our index in the queue using the released and ticket numbers.
-            uint64_t queueIndex = ticket - rel - 1;
-            queue[size_t(queueIndex)] = nullptr;
+        if (released.load(std::memory_order_relaxed) < ticket) {
+            abandon(ticket);
         } else {
             // We already got signaled. Forward that signal to some other task.
             signal(lock);
@@ -64,6 +71,21 @@ void Condition::await(std::unique_lock<Spinlock>& lock) {
     }
 
     lock.lock();
+
+    // The signal could have arrived together with the timeout, in which case we take it.
+    if (released.load(std::memory_order_relaxed) < ticket) {
+        abandon(ticket);
+        return false;
+    }
+
+    return true;
+}
+
+void Condition::abandon(uint64_t ticket) {
+    // Set our task to nullptr to signal that we don't want the lock anymore.
+    // We can calculate our index in the queue using the released and ticket numbers.
+    uint64_t queueIndex = ticket - released.load(std::memory_order_relaxed) - 1;
+    queue[size_t(queueIndex)] = nullptr;
 }
 
 void Condition::signal(std::unique_lock<Spinlock>& lock) {
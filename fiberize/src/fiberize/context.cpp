@@ -3,7 +3,7 @@
 #include <fiberize/exceptions.hpp>
 #include <fiberize/events.hpp>
 #include <fiberize/detail/task.hpp>
-#include <fiberize/detail/localfiberref.hpp>
+#include <fiberize/fiberref-inl.hpp>
 #include <fiberize/detail/singletaskscheduler.hpp>
 #include <fiberize/detail/multitaskscheduler.hpp>
 #include <fiberize/fibersystem.hpp>
@@ -51,18 +51,21 @@ static void initializeHandlers() {
      * This probably could be improved a lot.
      */
     auto task = detail::task();
-    std::unique_ptr<fiberize::detail::Handler> killHandler(new fiberize::detail::TypedHandler<void>([] () {
-        throw Killed();
-    }));
+    fiberize::detail::HandlerPtr killHandler = fiberize::detail::makeHandler<fiberize::detail::TypedHandler<void>>(
+        task->handlerArena, [] () {
+            throw Killed();
+        });
     killHandler->grab();
-    task->handlers[kill.path()].emplace_back(std::move(killHandler));
+    task->handlers[kill.id()].emplace_back(std::move(killHandler));
     task->handlersInitialized = true;
 }
 
-void processUntil(const bool& condition) {
+/**
+ * Processes events until either of the conditions is true.
+ */
+static void processUntilEither(const bool& condition, const bool& other) {
     auto task = detail::task();
-    PendingEvent event;
-    while (!condition) {
+    while (!condition && !other) {
         /**
          * First, process all pending events.
          */
@@ -70,29 +73,33 @@ void processUntil(const bool& condition) {
         std::unique_lock<Spinlock> lock(task->spinlock);
         while (task->mailbox->dequeue(event)) {
             lock.unlock();
+            task->mailbox->dequeued();
 
             if (!task->handlersInitialized)
                 initializeHandlers();
 
-            try {
-                detail::dispatchEvent(event);
-            } catch (...) {
-                if (event.freeData)
-                    event.freeData(event.data);
-                throw;
-            }
-            if (event.freeData)
-                event.freeData(event.data);
+            // Destroy the payload before taking the lock, its destructor could need it.
+            detail::dispatchEvent(event);
+            event.reset();
 
             /**
              * Short-circuit when condition is triggered.
              */
-            if (condition) {
+            if (condition || other) {
                 return;
             }
 
             lock.lock();
         }
+
+        /**
+         * Timers and other threads set the conditions under the task lock and resume us, which
+         * does nothing while we are running. Check again before accepting the resumes so far,
+         * otherwise that wakeup is lost.
+         */
+        if (condition || other)
+            return;
+
         task->resumesExpected = task->resumes;
         lock.unlock();
 
@@ -103,30 +110,62 @@ void processUntil(const bool& condition) {
     }
 }
 
+void processUntil(const bool& condition) {
+    static const bool never = false;
+    processUntilEither(condition, never);
+}
+
+bool processUntil(const bool& condition, std::chrono::steady_clock::time_point deadline) {
+    if (condition)
+        return true;
+
+    detail::Timeout timeout(deadline);
+    processUntilEither(condition, timeout.expired());
+    return condition;
+}
+
 FiberRef self() {
-    return FiberRef(std::make_shared<fiberize::detail::LocalFiberRef>(system(), detail::task()));
+    return FiberRef(detail::task());
 }
 
 namespace detail {
 
+/**
+ * Maximum number of events taken from the mailbox at once.
+ */
+constexpr size_t batchSize = 16;
+
 void process(std::unique_lock<Spinlock>& lock) {
-    PendingEvent event;
+    PendingEvent batch[batchSize];
     auto task = detail::task();
-    while (!task->stopped && task->mailbox->dequeue(event)) {
+    size_t remaining = task->throughput == 0 ? std::numeric_limits<size_t>::max() : task->throughput;
+
+    while (!task->stopped) {
+        if (remaining == 0) {
+            // Quota exhausted, the scheduler puts the task behind the other tasks, like yield() does.
+            task->resumesExpected = std::numeric_limits<uint64_t>::max();
+            return;
+        }
+
+        size_t n = task->mailbox->dequeueBatch(batch, std::min(batchSize, remaining));
+        if (n == 0)
+            break;
+
+        remaining -= n;
         lock.unlock();
+        task->mailbox->dequeued();
 
         if (!task->handlersInitialized)
             initializeHandlers();
 
-        try {
-            detail::dispatchEvent(event);
-        } catch (...) {
-            if (event.freeData)
-                event.freeData(event.data);
-            throw;
+        // Events left in the batch after the task stops are dropped, as they would be by kill.
+        for (size_t i = 0; i < n; ++i) {
+            if (!task->stopped)
+                detail::dispatchEvent(batch[i]);
+
+            // Destroy the payload before taking the lock, its destructor could need it.
+            batch[i].reset();
         }
-        if (event.freeData)
-            event.freeData(event.data);
         lock.lock();
     }
     task->resumesExpected = task->resumes;
@@ -136,6 +175,10 @@ fiberize::detail::Task* task() {
     return scheduler()->currentTask();
 }
 
+fiberize::detail::HandlerArena& handlerArena() {
+    return task()->handlerArena;
+}
+
 static void collectGarbage(fiberize::detail::HandlerBlock& block) {
     size_t i = 0;
 
@@ -156,10 +199,10 @@ void dispatchEvent(const PendingEvent& event) {
     /**
      * Find a handler block.
      */
-    auto blockIt = task->handlers.find(event.path);
-    if (blockIt == task->handlers.end())
+    fiberize::detail::HandlerBlock* found = task->handlers.find(event.id);
+    if (found == nullptr)
         return;
-    fiberize::detail::HandlerBlock& block = blockIt->second;
+    fiberize::detail::HandlerBlock& block = *found;
 
     /**
      * GC dead handlers.
@@ -170,7 +213,7 @@ void dispatchEvent(const PendingEvent& event) {
      * There are no alive handlers, remove the handler block.
      */
     if (block.empty()) {
-        task->handlers.erase(blockIt);
+        task->handlers.erase(event.id);
         return;
     }
 
@@ -180,14 +223,14 @@ void dispatchEvent(const PendingEvent& event) {
     auto it = block.rbegin();
     auto end = block.rend();
     while (it != end) {
-        (*it)->execute(event.data);
+        (*it)->execute(event.data());
         ++it;
     }
 }
 
-HandlerRef bind(const Path& path, std::unique_ptr<fiberize::detail::Handler> handler) {
+HandlerRef bind(EventId id, fiberize::detail::HandlerPtr handler) {
     HandlerRef ref(handler.get());
-    task()->handlers[path].emplace_back(std::move(handler));
+    task()->handlers[id].emplace_back(std::move(handler));
     return ref;
 }
 
@@ -241,6 +284,98 @@ void resume(fiberize::detail::Task* task, std::unique_lock<Spinlock> lock) {
     }
 }
 
+void deliver(fiberize::detail::Task* task, PendingEvent&& event) {
+    Mailbox* mailbox = task->mailbox.get();
+    if (mailbox->concurrentEnqueue()) {
+        /**
+         * Only the sender that found the mailbox empty has to resume the task. The receiver checks
+         * the mailbox and updates resumesExpected under the task lock, so it cannot miss us.
+         */
+        if (mailbox->enqueue(std::move(event)))
+            resume(task);
+    } else {
+        std::unique_lock<Spinlock> lock(task->spinlock);
+        mailbox->enqueue(std::move(event));
+        resume(task, std::move(lock));
+    }
+}
+
+struct Timeout::State : public fiberize::detail::Timer, public fiberize::detail::ReferenceCountedAtomic {
+    virtual ~State() {
+        task->drop();
+    }
+
+    static void callback(fiberize::detail::Timer* timer) {
+        auto state = static_cast<State*>(timer);
+        {
+            std::unique_lock<Spinlock> lock(state->task->spinlock);
+            if (!state->cancelled) {
+                state->timedOut = true;
+                resume(state->task, std::move(lock));
+            }
+        }
+        state->drop();
+    }
+
+    static void withdrawnCallback(fiberize::detail::Timer* timer, bool removed) {
+        auto state = static_cast<State*>(timer);
+
+        // The wheel's reference, unless the timer expired, and the reference of the request.
+        if (removed)
+            state->drop();
+        state->drop();
+    }
+
+    Scheduler* scheduler;
+    fiberize::detail::Task* task;
+    bool timedOut;
+    bool cancelled;
+};
+
+Timeout::Timeout(std::chrono::steady_clock::time_point deadline)
+    : state(new State) {
+    state->timedOut = false;
+    state->cancelled = false;
+    state->scheduler = scheduler();
+    state->task = task();
+    state->task->grab();
+    state->expired = State::callback;
+    state->withdrawn = State::withdrawnCallback;
+
+    // One reference for us and one for the wheel.
+    state->grab();
+    state->grab();
+    state->scheduler->timers().schedule(state, fiberize::detail::TimerWheel::deadlineOf(deadline));
+}
+
+Timeout::~Timeout() {
+    {
+        std::unique_lock<Spinlock> lock(state->task->spinlock);
+        state->cancelled = true;
+    }
+
+    if (Scheduler::current() == state->scheduler) {
+        if (state->scheduled) {
+            state->scheduler->timers().cancel(state);
+            state->drop();
+        }
+    } else {
+        /**
+         * The task migrated and only the owner of the wheel can touch it. Ask it to remove the
+         * timer, the request holds a reference until it's processed.
+         */
+        state->grab();
+        state->scheduler->timers().cancelConcurrent(state);
+        state->scheduler->unpark();
+    }
+
+    state->drop();
+}
+
+const bool& Timeout::expired() const {
+    return state->timedOut;
+}
+
 } // namespace detail
 
 } // namespace context
@@ -0,0 +1,81 @@
+/**
+ * Stack allocator with guard pages.
+ *
+ * @file guardedstack.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/guardedstack.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fiberize {
+namespace detail {
+
+static size_t pageSize() {
+    static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+static size_t roundUpToPage(size_t size) {
+    return (size + pageSize() - 1) & ~(pageSize() - 1);
+}
+
+GuardedStackAllocator::GuardedStackAllocator(size_t size)
+    : size(roundUpToPage(size)) {}
+
+boost::context::stack_context GuardedStackAllocator::allocate() {
+    const size_t total = size + pageSize();
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        throw std::bad_alloc();
+
+    // The stack grows down, the guard page goes at the lowest address.
+    if (mprotect(base, pageSize(), PROT_NONE) != 0) {
+        munmap(base, total);
+        throw std::bad_alloc();
+    }
+
+    boost::context::stack_context stack;
+    stack.size = size;
+    stack.sp = static_cast<char*>(base) + total;
+    return stack;
+}
+
+void GuardedStackAllocator::deallocate(boost::context::stack_context& stack) {
+    char* base = static_cast<char*>(stack.sp) - stack.size - pageSize();
+    munmap(base, stack.size + pageSize());
+}
+
+void GuardedStackAllocator::release(const boost::context::stack_context& stack, const void* sp, bool lazy) {
+    uintptr_t top = reinterpret_cast<uintptr_t>(stack.sp);
+    uintptr_t bottom = top - stack.size;
+    uintptr_t used = reinterpret_cast<uintptr_t>(sp);
+
+    // Don't touch anything if the pointer is not on this stack.
+    if (used <= bottom || used > top)
+        return;
+
+    // Keep the page with the stack pointer and one page below it, for the red zone and the
+    // frames pushed right after resuming.
+    uintptr_t end = (used & ~(pageSize() - 1));
+    if (end < bottom + pageSize())
+        return;
+    end -= pageSize();
+    if (end <= bottom)
+        return;
+
+#ifdef MADV_FREE
+    if (lazy && madvise(reinterpret_cast<void*>(bottom), end - bottom, MADV_FREE) == 0)
+        return;
+#endif
+    madvise(reinterpret_cast<void*>(bottom), end - bottom, MADV_DONTNEED);
+}
+
+} // namespace detail
+} // namespace fiberize
@@ -0,0 +1,27 @@
+/**
+ * Per task allocator of event handlers.
+ *
+ * @file handlerarena.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/handlerarena.hpp>
+
+namespace fiberize {
+namespace detail {
+
+constexpr size_t HandlerArena::slotSize;
+constexpr size_t HandlerArena::chunkSize;
+
+HandlerArena::HandlerArena() : free(nullptr) {}
+
+void HandlerArena::grow() {
+    std::unique_ptr<Slot[]> chunk(new Slot[chunkSize]);
+    for (size_t i = chunkSize; i > 0; --i) {
+        chunk[i - 1].next = free;
+        free = &chunk[i - 1];
+    }
+    chunks.emplace_back(std::move(chunk));
+}
+
+} // namespace detail
+} // namespace fiberize
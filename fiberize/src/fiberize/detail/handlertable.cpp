@@ -0,0 +1,117 @@
+/**
+ * Flat hash table of event handlers.
+ *
+ * @file handlertable.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/handlertable.hpp>
+
+namespace fiberize {
+namespace detail {
+
+constexpr size_t initialCapacity = 8;
+constexpr EventId HandlerTable::emptyId;
+
+HandlerTable::HandlerTable()
+    : size_(0), mask(0), shift(64) {}
+
+size_t HandlerTable::locate(EventId id) const {
+    if (slots.empty())
+        return size_t(-1);
+
+    size_t i = home(id);
+    for (;;) {
+        if (slots[i].id == id)
+            return i;
+        if (slots[i].id == emptyId)
+            return size_t(-1);
+        i = (i + 1) & mask;
+    }
+}
+
+HandlerBlock* HandlerTable::find(EventId id) {
+    size_t i = locate(id);
+    if (i == size_t(-1)) {
+        return nullptr;
+    } else {
+        return &slots[i].block;
+    }
+}
+
+HandlerBlock& HandlerTable::operator [] (EventId id) {
+    if ((size_ + 1) * 2 > slots.size())
+        grow();
+
+    size_t i = home(id);
+    for (;;) {
+        if (slots[i].id == id)
+            return slots[i].block;
+        if (slots[i].id == emptyId)
+            break;
+        i = (i + 1) & mask;
+    }
+
+    slots[i].id = id;
+    size_ += 1;
+    return slots[i].block;
+}
+
+void HandlerTable::erase(EventId id) {
+    size_t i = locate(id);
+    if (i == size_t(-1))
+        return;
+
+    // Shift back the following entries of the cluster, until one of them is at its home slot.
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (slots[j].id == emptyId)
+            break;
+
+        // Skip entries whose home lies cyclically in (i, j], they must stay after the hole.
+        size_t k = home(slots[j].id);
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        slots[i].id = slots[j].id;
+        slots[i].block = std::move(slots[j].block);
+        i = j;
+    }
+
+    slots[i].id = emptyId;
+    slots[i].block.clear();
+    size_ -= 1;
+}
+
+void HandlerTable::clear() {
+    slots.clear();
+    size_ = 0;
+    mask = 0;
+    shift = 64;
+}
+
+void HandlerTable::grow() {
+    size_t capacity = slots.empty() ? initialCapacity : slots.size() * 2;
+    std::vector<Slot> old;
+    old.swap(slots);
+
+    slots.resize(capacity);
+    for (Slot& slot : slots)
+        slot.id = emptyId;
+    mask = capacity - 1;
+    shift = 64 - __builtin_ctzll(capacity);
+
+    for (Slot& slot : old) {
+        if (slot.id == emptyId)
+            continue;
+
+        size_t i = home(slot.id);
+        while (slots[i].id != emptyId)
+            i = (i + 1) & mask;
+        slots[i].id = slot.id;
+        slots[i].block = std::move(slot.block);
+    }
+}
+
+} // namespace detail
+} // namespace fiberize
@@ -11,18 +11,21 @@ namespace fiberize {
 namespace detail {
 
 constexpr uint64_t sameStreakLimit = 64;
-constexpr uint64_t stashSize = 256;
 constexpr uint64_t stealTries = 2;
 
-MultiTaskScheduler::MultiTaskScheduler(FiberSystem* system, uint64_t seed)
+MultiTaskScheduler::MultiTaskScheduler(FiberSystem* system, uint64_t seed, const CpuLocation& location, bool pin)
     : Scheduler(system, seed)
     , stopping(false)
+    , location_(location)
+    , pin(pin)
+    , searching(false)
+    , inbox(nullptr)
     , sameStreak(0)
     , suspendingTask(nullptr)
     , currentTask_(nullptr)
-    , unowned(nullptr) {
-    stash.reserve(stashSize);
-}
+    , unowned(nullptr)
+    , abandoned(nullptr)
+    , stacks(system->stackPools_[location.node].get(), [] (intptr_t) { unownedLoop(); }) {}
 
 MultiTaskScheduler::~MultiTaskScheduler() {
     if (!stopping.load(std::memory_order_consume))
@@ -30,43 +33,223 @@ MultiTaskScheduler::~MultiTaskScheduler() {
 }
 
 void MultiTaskScheduler::start() {
+    findNeighbours();
+
     thread = std::thread([this] () {
+        // Pin before touching any memory, so that the stacks are allocated on our node.
+        if (pin)
+            pinThisThread(location_.cpu);
+
         makeCurrent();
-        unowned = stashGet();
+        unowned = stacks.get(StackClasses::defaultClass());
         boost::context::jump_fcontext(&initialContext, unowned->context, 0);
         if (unowned != nullptr) {
-            stashPut(unowned);
+            stacks.put(unowned);
             unowned = nullptr;
         }
         resetCurrent();
     });
 }
 
+void MultiTaskScheduler::findNeighbours() {
+    const auto& schedulers = system()->schedulers();
+    std::vector<CpuLocation> locations;
+    size_t self = 0;
+    for (size_t i = 0; i < schedulers.size(); ++i) {
+        locations.push_back(schedulers[i]->location_);
+        if (schedulers[i] == this)
+            self = i;
+    }
+
+    auto levels = detail::neighbours(locations, self);
+    for (size_t level = 0; level < distanceLevels; ++level) {
+        neighbours[level].clear();
+        for (size_t i : levels[level])
+            neighbours[level].push_back(schedulers[i]);
+    }
+}
+
 void MultiTaskScheduler::stop() {
-    stopping.store(true, std::memory_order_release);
+    stopping.store(true, std::memory_order_seq_cst);
+    unpark();
     thread.join();
-    stashClear();
+    stacks.clear();
 }
 
 void MultiTaskScheduler::resume(Task* task, std::unique_lock<Spinlock> lock) {
     assert(lock.owns_lock());
     assert(task->status == Starting || task->status == Listening || task->status == Suspended);
     assert(!task->scheduled);
-    TaskStatus status = task->status;
     task->resumes += 1;
     task->scheduled = true;
     lock.unlock();
 
+    if (current() == this) {
+        enqueue(task);
+    } else {
+        // Only the owner can push to the run queues.
+        pushInbox(task);
+        unpark();
+    }
+}
+
+void MultiTaskScheduler::requeue(Task* task, std::unique_lock<Spinlock> lock) {
+    assert(lock.owns_lock());
+    assert(task->status == Listening || task->status == Suspended);
+    assert(!task->scheduled);
+    task->resumes += 1;
+    task->scheduled = true;
+    bool pinned = task->pin != nullptr;
+    lock.unlock();
+
+    if (pinned) {
+        pinnedYieldedTasks.push_back(task);
+    } else {
+        yieldedTasks.push(task);
+
+        // Idle schedulers can take it while we are busy with other work.
+        wakeSleeper();
+    }
+}
+
+void MultiTaskScheduler::dequeueYielded(Task*& task) {
+    if (!pinnedYieldedTasks.empty()) {
+        task = pinnedYieldedTasks.front();
+        pinnedYieldedTasks.pop_front();
+    } else {
+        task = yieldedTasks.steal();
+    }
+}
+
+void MultiTaskScheduler::pushInbox(Task* task) {
+    task->inboxNext = inbox.load(std::memory_order_relaxed);
+    while (!inbox.compare_exchange_weak(task->inboxNext, task, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        // Retry.
+    }
+}
+
+void MultiTaskScheduler::drainInbox() {
+    if (inbox.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    // Take the whole stack at once and reverse it to restore the arrival order.
+    Task* stack = inbox.exchange(nullptr, std::memory_order_acquire);
+    Task* reversed = nullptr;
+    while (stack != nullptr) {
+        Task* next = stack->inboxNext;
+        stack->inboxNext = reversed;
+        reversed = stack;
+        stack = next;
+    }
+
+    while (reversed != nullptr) {
+        Task* next = reversed->inboxNext;
+        reversed->inboxNext = nullptr;
+        enqueue(reversed);
+        reversed = next;
+    }
+}
+
+void MultiTaskScheduler::enqueue(Task* task) {
+    // The task is scheduled, so nobody else can change its status or pin.
+    TaskStatus status = task->status;
+    bool pinned = task->pin != nullptr;
+
     if (status == Starting || status == Listening) {
-        std::unique_lock<Spinlock> lock(softMutex);
-        softTasks.push_front(task);
+        if (pinned) {
+            pinnedSoftTasks.push_front(task);
+        } else {
+            softTasks.push(task);
+        }
     } else if (status == Suspended) {
-        std::unique_lock<Spinlock> lock(hardMutex);
-        hardTasks.push_front(task);
+        if (pinned) {
+            pinnedHardTasks.push_front(task);
+        } else {
+            hardTasks.push(task);
+        }
     } else {
         // Impossible.
         __builtin_unreachable();
     }
+
+    // The task can be stolen, let a parked scheduler know about it.
+    if (!pinned)
+        wakeSleeper();
+}
+
+void MultiTaskScheduler::park() {
+    FiberSystem* system = this->system();
+
+    // A parking scheduler is not searching anymore, this must happen before canPark().
+    if (searching) {
+        searching = false;
+        system->searching_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    system->sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    Scheduler::park();
+    system->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+
+    searching = true;
+    system->searching_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+bool MultiTaskScheduler::canPark() {
+    if (stopping.load(std::memory_order_seq_cst))
+        return false;
+
+    if (inbox.load(std::memory_order_seq_cst) != nullptr)
+        return false;
+
+    if (!pinnedSoftTasks.empty() || !pinnedHardTasks.empty() || !pinnedYieldedTasks.empty())
+        return false;
+
+    for (MultiTaskScheduler* scheduler : system()->schedulers()) {
+        if (!scheduler->softTasks.empty() || !scheduler->hardTasks.empty()
+            || !scheduler->yieldedTasks.empty())
+            return false;
+    }
+
+    return true;
+}
+
+void MultiTaskScheduler::stopSearching() {
+    if (!searching)
+        return;
+
+    searching = false;
+    FiberSystem* system = this->system();
+
+    // If we were the last one searching, someone else has to pick up the remaining work.
+    if (system->searching_.fetch_sub(1, std::memory_order_seq_cst) == 1)
+        wakeSleeper();
+}
+
+void MultiTaskScheduler::wakeSleeper() {
+    FiberSystem* system = this->system();
+
+    /**
+     * Pairs with the announcement in park(). Either the parking scheduler sees the task we
+     * have just enqueued, or we see that it is parked.
+     */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (system->searching_.load(std::memory_order_relaxed) != 0
+        || system->sleepers_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    // Wake up the closest scheduler, it will most likely steal the work from us.
+    for (const auto& level : neighbours) {
+        size_t n = level.size();
+        if (n == 0)
+            continue;
+
+        std::uniform_int_distribution<size_t> dist(0, n-1);
+        size_t start = dist(random());
+        for (size_t i = 0; i < n; ++i) {
+            if (level[(start + i) % n]->unpark())
+                return;
+        }
+    }
 }
 
 void MultiTaskScheduler::suspend() {
@@ -87,65 +270,67 @@ bool MultiTaskScheduler::isMultiTasking() {
 }
 
 void MultiTaskScheduler::dequeueSoft(Task*& task) {
-    std::unique_lock<Spinlock> lock(softMutex);
-    if (!softTasks.empty()) {
-        task = softTasks.front();
-        softTasks.pop_front();
+    // Pinned tasks first, they cannot be picked up by anyone else.
+    if (!pinnedSoftTasks.empty()) {
+        task = pinnedSoftTasks.front();
+        pinnedSoftTasks.pop_front();
+    } else {
+        task = softTasks.pop();
     }
 }
 
 void MultiTaskScheduler::stealSoft(Task*& task) {
-    std::unique_lock<Spinlock> lock(softMutex);
-    if (!softTasks.empty() && softTasks.back()->pin == nullptr) {
-        task = softTasks.back();
-        softTasks.pop_back();
-    }
+    task = softTasks.steal();
 }
 
 void MultiTaskScheduler::dequeueHard(Task*& task) {
-    std::unique_lock<Spinlock> lock(hardMutex);
-    if (!hardTasks.empty()) {
-        task = hardTasks.front();
-        hardTasks.pop_front();
+    // Pinned tasks first, they cannot be picked up by anyone else.
+    if (!pinnedHardTasks.empty()) {
+        task = pinnedHardTasks.front();
+        pinnedHardTasks.pop_front();
+    } else {
+        task = hardTasks.pop();
     }
 }
 
 void MultiTaskScheduler::stealHard(Task*& task) {
-    std::unique_lock<Spinlock> lock(hardMutex);
-    if (!hardTasks.empty() && hardTasks.back()->pin == nullptr) {
-        task = hardTasks.back();
-        hardTasks.pop_back();
-    }
+    task = hardTasks.steal();
 }
 
 void MultiTaskScheduler::dequeue(Task*& task, MultiTaskScheduler::Priority priority) {
+    drainInbox();
+
     if (priority == Soft) {
-        for (int i = 0; i < 2; ++i) {
-            dequeueSoft(task); if (task) return;
-            dequeueHard(task); if (task) return;
-        }
+        dequeueSoft(task); if (task) return;
+        dequeueHard(task); if (task) return;
     } else {
-        for (int i = 0; i < 2; ++i) {
-            dequeueHard(task); if (task) return;
-            dequeueSoft(task); if (task) return;
-        }
+        dequeueHard(task); if (task) return;
+        dequeueSoft(task); if (task) return;
     }
+
+    dequeueYielded(task);
 }
 
 void MultiTaskScheduler::steal(Task*& task, MultiTaskScheduler::Priority priority) {
-    size_t n = system()->schedulers().size();
-    std::uniform_int_distribution<size_t> dist(0, n-1);
+    // Look for work close to us first, stealing from a remote node moves the task and its stack
+    // away from the memory they were allocated in.
+    for (const auto& level : neighbours) {
+        size_t n = level.size();
+        if (n == 0)
+            continue;
 
-    for (uint i = 0; i < stealTries; ++i) {
-        size_t index = dist(random());
-        auto target = system()->schedulers()[index];
+        std::uniform_int_distribution<size_t> dist(0, n-1);
+        for (uint i = 0; i < stealTries; ++i) {
+            auto target = level[dist(random())];
 
-        if (priority == Soft) {
-            target->stealSoft(task); if (task) return;
-            target->stealHard(task); if (task) return;
-        } else {
-            target->stealHard(task); if (task) return;
-            target->stealSoft(task); if (task) return;
+            if (priority == Soft) {
+                target->stealSoft(task); if (task) return;
+                target->stealHard(task); if (task) return;
+            } else {
+                target->stealHard(task); if (task) return;
+                target->stealSoft(task); if (task) return;
+            }
+            task = target->yieldedTasks.steal(); if (task) return;
         }
     }
 }
@@ -176,8 +361,10 @@ void MultiTaskScheduler::finishSuspending() {
         suspendingTask->status = Suspended;
         suspendingTask->scheduled = false;
 
-        // Reschedule the task if required.
-        if (suspendingTask->resumes != suspendingTask->resumesExpected) {
+        // Reschedule the task if required, behind the other tasks if it yielded.
+        if (suspendingTask->resumesExpected == std::numeric_limits<uint64_t>::max()) {
+            requeue(suspendingTask, std::move(lock));
+        } else if (suspendingTask->resumes != suspendingTask->resumesExpected) {
             resume(suspendingTask, std::move(lock));
         }
 
@@ -198,7 +385,8 @@ void MultiTaskScheduler::ownedLoop() {
     }
 
     // Perform the periodic IO check.
-    self->ioContext().throttledPoll();
+    self->ioContext().throttledPoll(self->system()->ioPollInterval());
+    self->expireTimers();
 
     self->suspendingTask = self->currentTask_;
     self->currentTask_ = nullptr;
@@ -214,14 +402,14 @@ void MultiTaskScheduler::ownedLoop() {
     // If we still don't have any task, jump into an unowned context.
     if (self->currentTask_ == nullptr) {
         self->sameStreak = 0;
-        self->unowned = self->stashGet();
+        self->unowned = self->stacks.get(StackClasses::defaultClass());
         boost::context::jump_fcontext(&self->suspendingTask->context, self->unowned->context, 0);
     } else {
         // We got a task, execute it.
         if (self->currentTask_->status == Starting || self->currentTask_->status == Listening) {
             // We cannot start a new task on an owned stack. Let's get a new stack and jump to it.
             self->sameStreak = 0;
-            self->unowned = self->stashGet();
+            self->unowned = self->stacks.get(stackClassOf(self->currentTask_));
             boost::context::jump_fcontext(&self->suspendingTask->context, self->unowned->context, 0);
         } else if (self->currentTask_->status == Suspended) {
             // Jump back to a suspended task.
@@ -241,7 +429,7 @@ void MultiTaskScheduler::ownedLoop() {
 
     // If we jumped form an unowned context we have to stash it.
     if (self->unowned != nullptr) {
-        self->stashPut(self->unowned);
+        self->stacks.put(self->unowned);
         self->unowned = nullptr;
     }
 
@@ -259,6 +447,12 @@ void MultiTaskScheduler::unownedLoop() {
         // Refresh self, in case we got migrated.
         MultiTaskScheduler* self = static_cast<MultiTaskScheduler*>(current());
 
+        // Pool the context we switched away from, if it had the wrong stack size.
+        if (self->abandoned != nullptr) {
+            self->stacks.put(self->abandoned);
+            self->abandoned = nullptr;
+        }
+
         // If the scheduler is stopping return to the initial context.
         if (self->stopping.load(std::memory_order_consume)) {
             boost::context::jump_fcontext(&self->unowned->context, self->initialContext, 0);
@@ -266,7 +460,8 @@ void MultiTaskScheduler::unownedLoop() {
         }
 
         // Perform the periodic IO check.
-        self->ioContext().throttledPoll();
+        self->ioContext().throttledPoll(self->system()->ioPollInterval());
+        self->expireTimers();
 
         // We might have to suspend a task, after a jump from the owned loop.
         self->finishSuspending();
@@ -283,14 +478,34 @@ void MultiTaskScheduler::unownedLoop() {
         // If we still don't have any task, try again or go to sleep,
         // depending on how long are we spinning.
         if (self->currentTask_ == nullptr) {
-            self->idle(idleStreak);
+            // Check for IO completions before going idle, they could give us some work.
+            if (self->ioContext().active() && self->ioContext().poll()) {
+                idleStreak = 0;
+            } else {
+                self->idle(idleStreak);
+            }
             continue;
         } else {
             idleStreak = 0;
+            self->stopSearching();
         }
 
         TaskStatus status = self->currentTask_->status;
         if (status == Starting || status == Listening) {
+            // Switch to a stack of the size requested by the task. The new context finds the
+            // task in currentTask_. Listening actors keep the stack only if a handler suspends,
+            // so they run on any stack that is big enough.
+            size_t sizeClass = stackClassOf(self->currentTask_);
+            bool fits = status == Listening
+                ? self->unowned->sizeClass >= sizeClass
+                : self->unowned->sizeClass == sizeClass;
+            if (!fits) {
+                self->abandoned = self->unowned;
+                self->unowned = self->stacks.get(sizeClass);
+                boost::context::jump_fcontext(&self->abandoned->context, self->unowned->context, 0);
+                continue;
+            }
+
             self->sameStreak += 1;
 
             // The context becomes owned.
@@ -338,8 +553,10 @@ void MultiTaskScheduler::unownedLoop() {
             if (!self->currentTask_->stopped) {
                 self->currentTask_->status = Listening;
 
-                // Reschedule the task if required.
-                if (self->currentTask_->resumesExpected != self->currentTask_->resumes) {
+                // Reschedule the task if required, behind the other tasks if it used up its quota.
+                if (self->currentTask_->resumesExpected == std::numeric_limits<uint64_t>::max()) {
+                    self->requeue(self->currentTask_, std::move(lock));
+                } else if (self->currentTask_->resumesExpected != self->currentTask_->resumes) {
                     self->resume(self->currentTask_, std::move(lock));
                 } else {
                     lock.unlock();
@@ -362,40 +579,8 @@ void MultiTaskScheduler::unownedLoop() {
     }
 }
 
-MultiTaskScheduler::UnownedContext* MultiTaskScheduler::stashGet() {
-    UnownedContext* context;
-
-    if (!stash.empty()) {
-        context = stash.back();
-        stash.pop_back();
-    } else {
-        // Create a new context.
-        context = new UnownedContext;
-        context->stack = stackAllocator.allocate();
-        context->context = boost::context::make_fcontext(context->stack.sp, context->stack.size, [] (intptr_t) {
-            unownedLoop();
-        });
-    }
-
-    return context;
-}
-
-void MultiTaskScheduler::stashPut(UnownedContext* context) {
-    assert(context != nullptr);
-    if (stash.size() < stashSize) {
-        stash.push_back(context);
-    } else {
-        stackAllocator.deallocate(context->stack);
-        delete context;
-    }
-}
-
-void MultiTaskScheduler::stashClear() {
-    for (UnownedContext* context : stash) {
-        stackAllocator.deallocate(context->stack);
-        delete context;
-    }
-    stash.clear();
+size_t MultiTaskScheduler::stackClassOf(Task* task) {
+    return StackClasses::classOf(task->stackSize);
 }
 
 } // namespace detail
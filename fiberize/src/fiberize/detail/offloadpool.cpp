@@ -0,0 +1,133 @@
+/**
+ * Pool of threads executing blocking calls.
+ *
+ * @file offloadpool.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/offloadpool.hpp>
+#include <fiberize/detail/task.hpp>
+#include <fiberize/context.hpp>
+
+#include <algorithm>
+
+namespace fiberize {
+namespace detail {
+
+OffloadJob::OffloadJob() : task(nullptr), done(false) {}
+
+OffloadJob::~OffloadJob() {
+    if (task != nullptr)
+        task->drop();
+}
+
+constexpr size_t OffloadPool::defaultMaxThreads;
+constexpr std::chrono::seconds OffloadPool::defaultIdleTimeout;
+
+OffloadPool::OffloadPool()
+    : maxThreads_(defaultMaxThreads), idleTimeout_(defaultIdleTimeout)
+    , idle(0), running(0), completed(0), stopping(false) {}
+
+OffloadPool::~OffloadPool() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopping = true;
+    available.notify_all();
+    exited.wait(lock, [this] () { return workers.empty(); });
+    lock.unlock();
+
+    joinFinished();
+}
+
+void OffloadPool::submit(OffloadJob* job) {
+    job->grab();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    queue.push_back(job);
+
+    // Every idle thread takes one call. Start a new thread for the rest, if we can.
+    if (queue.size() > idle && workers.size() < maxThreads_) {
+        workers.emplace_back();
+        auto self = std::prev(workers.end());
+        *self = std::thread(&OffloadPool::work, this, self);
+    } else {
+        available.notify_one();
+    }
+    lock.unlock();
+
+    joinFinished();
+}
+
+void OffloadPool::maxThreads(size_t maxThreads) {
+    std::unique_lock<std::mutex> lock(mutex);
+    maxThreads_ = std::max<size_t>(maxThreads, 1);
+    available.notify_all();
+}
+
+void OffloadPool::idleTimeout(std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    idleTimeout_ = timeout;
+    available.notify_all();
+}
+
+OffloadStats OffloadPool::stats() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return OffloadStats{workers.size(), idle, running, queue.size(), completed};
+}
+
+void OffloadPool::work(std::list<std::thread>::iterator self) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        if (queue.empty()) {
+            if (stopping || workers.size() > maxThreads_)
+                break;
+
+            idle += 1;
+            auto status = available.wait_for(lock, idleTimeout_);
+            idle -= 1;
+
+            if (status == std::cv_status::timeout && queue.empty())
+                break;
+            continue;
+        }
+
+        OffloadJob* job = queue.front();
+        queue.pop_front();
+        running += 1;
+        lock.unlock();
+
+        job->execute();
+
+        // Update the stats before the fiber can see the result.
+        lock.lock();
+        running -= 1;
+        completed += 1;
+        lock.unlock();
+
+        // Wake up the fiber. It's pinned, so this doesn't need a scheduler on this thread.
+        {
+            std::unique_lock<Spinlock> taskLock(job->task->spinlock);
+            job->done = true;
+            context::detail::resume(job->task, std::move(taskLock));
+        }
+        job->drop();
+
+        lock.lock();
+    }
+
+    // The thread can't join itself, the next submit or the destructor will.
+    finished.splice(finished.end(), workers, self);
+    exited.notify_all();
+}
+
+void OffloadPool::joinFinished() {
+    std::list<std::thread> joinable;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        joinable.swap(finished);
+    }
+
+    for (std::thread& thread : joinable)
+        thread.join();
+}
+
+} // namespace detail
+} // namespace fiberize
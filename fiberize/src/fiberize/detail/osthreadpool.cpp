@@ -0,0 +1,159 @@
+/**
+ * Pool of threads running OS thread tasks.
+ *
+ * @file osthreadpool.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/osthreadpool.hpp>
+#include <fiberize/detail/singletaskscheduler.hpp>
+#include <fiberize/detail/task.hpp>
+#include <fiberize/context.hpp>
+
+#include <cassert>
+#include <thread>
+
+namespace fiberize {
+namespace detail {
+
+namespace {
+
+/**
+ * Runs the task and processes its events until it stops.
+ */
+void runTask(SingleTaskScheduler& scheduler, Task* task) {
+    scheduler.assign(task);
+
+    // From now on events are forwarded to our scheduler.
+    std::unique_lock<Spinlock> startLock(task->spinlock);
+    task->status = Running;
+    task->scheduled = false;
+    startLock.unlock();
+
+    // Run the task. This doesn't throw.
+    task->runnable->run();
+
+    // Process events.
+    try {
+        while (!task->stopped) {
+            std::unique_lock<Spinlock> lock(task->spinlock);
+            context::detail::process(lock);
+            lock.unlock();
+
+            // Sleep until someone sends us an event.
+            if (!task->stopped)
+                scheduler.suspend();
+        }
+    } catch (...) {
+        // Nothing,
+    }
+
+    std::unique_lock<Spinlock> lock(task->spinlock);
+    Scheduler::kill(task, std::move(lock));
+
+    // The task can be gone, don't touch it.
+    scheduler.assign(nullptr);
+}
+
+} // namespace
+
+constexpr size_t OSThreadPool::defaultMaxIdle;
+constexpr std::chrono::seconds OSThreadPool::defaultIdleTimeout;
+
+OSThreadPool::OSThreadPool(FiberSystem* system) : system(system), state(new State) {
+    state->maxIdle = defaultMaxIdle;
+    state->idleTimeout = defaultIdleTimeout;
+    state->threads = 0;
+    state->busy = 0;
+    state->idle = 0;
+    state->stopping = false;
+}
+
+OSThreadPool::~OSThreadPool() {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->stopping = true;
+    state->available.notify_all();
+
+    // Wait until the idle threads destroy their schedulers.
+    state->exited.wait(lock, [this] () { return state->threads == state->busy; });
+}
+
+void OSThreadPool::run(Task* task, uint64_t seed) {
+    /**
+     * The task isn't pinned until a thread takes it. Mark it as scheduled, so that events sent in
+     * the meantime don't resume it on a multi tasking scheduler.
+     */
+    {
+        std::unique_lock<Spinlock> taskLock(task->spinlock);
+        assert(!task->scheduled);
+        task->scheduled = true;
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->queue.push_back(task);
+
+    // Every idle thread takes one task. Start a new thread for the rest.
+    if (state->queue.size() > state->idle) {
+        state->threads += 1;
+        std::thread(work, state, system, seed).detach();
+    } else {
+        state->available.notify_one();
+    }
+}
+
+void OSThreadPool::maxIdle(size_t maxIdle) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->maxIdle = maxIdle;
+}
+
+void OSThreadPool::idleTimeout(std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->idleTimeout = timeout;
+    state->available.notify_all();
+}
+
+size_t OSThreadPool::idle() {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    return state->idle;
+}
+
+void OSThreadPool::work(std::shared_ptr<State> state, FiberSystem* system, uint64_t seed) {
+    std::unique_ptr<SingleTaskScheduler> scheduler{new SingleTaskScheduler(system, seed, nullptr)};
+    scheduler->makeCurrent();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    for (;;) {
+        if (state->queue.empty()) {
+            if (state->stopping || state->idle >= state->maxIdle)
+                break;
+
+            state->idle += 1;
+            auto status = state->available.wait_for(lock, state->idleTimeout);
+            state->idle -= 1;
+
+            if (status == std::cv_status::timeout && state->queue.empty())
+                break;
+            continue;
+        }
+
+        Task* task = state->queue.front();
+        state->queue.pop_front();
+        state->busy += 1;
+        lock.unlock();
+
+        runTask(*scheduler, task);
+
+        lock.lock();
+        state->busy -= 1;
+    }
+    lock.unlock();
+
+    scheduler->resetCurrent();
+    scheduler.reset();
+
+    lock.lock();
+    state->threads -= 1;
+    state->exited.notify_all();
+}
+
+} // namespace detail
+} // namespace fiberize
@@ -13,17 +13,6 @@ namespace detail {
 ReferenceCountedAtomic::ReferenceCountedAtomic() : count(0) {}
 ReferenceCountedAtomic::~ReferenceCountedAtomic() {}
 
-void ReferenceCountedAtomic::grab() {
-    std::atomic_fetch_add_explicit(&count, 1u, std::memory_order_relaxed);
-}
-
-void ReferenceCountedAtomic::drop() {
-    if (std::atomic_fetch_sub_explicit(&count, 1u, std::memory_order_release) == 1u) {
-        std::atomic_thread_fence(std::memory_order_acquire);
-        delete this;
-    }
-}
-
 void intrusive_ptr_add_ref(ReferenceCountedAtomic* ptr) {
     ptr->grab();
 }
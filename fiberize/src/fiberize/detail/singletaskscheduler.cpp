@@ -14,8 +14,11 @@ namespace detail {
 
 SingleTaskScheduler::SingleTaskScheduler(FiberSystem* system, uint64_t seed, Task* task)
     : Scheduler(system, seed)
-    , task_(task) {
-    task->pin = this;
+    , task_(task)
+    , resumed(false) {
+    if (task != nullptr) {
+        task->pin = this;
+    }
 }
 
 SingleTaskScheduler::~SingleTaskScheduler() {
@@ -24,13 +27,24 @@ SingleTaskScheduler::~SingleTaskScheduler() {
     }
 }
 
+void SingleTaskScheduler::assign(Task* task) {
+    task_ = task;
+    resumed.store(false, std::memory_order_relaxed);
+    if (task != nullptr) {
+        task->pin = this;
+    }
+}
+
 void SingleTaskScheduler::resume(std::unique_lock<Spinlock> lock) {
     assert(task_->status == Suspended || task_->status == Listening);
     assert(!task_->scheduled);
     task_->status = Running;
     task_->scheduled = false;
     task_->resumes += 1;
-    resumed.store(true, std::memory_order_release);
+    resumed.store(true, std::memory_order_seq_cst);
+
+    // Wake up the thread while holding the lock, the scheduler dies together with the task.
+    unpark();
     lock.unlock();
 }
 
@@ -53,7 +67,7 @@ void SingleTaskScheduler::suspend() {
      */
     uint64_t idleStreak = 0;
     while (!resumed.load(std::memory_order_acquire)) {
-        if (ioContext().poll()) {
+        if (ioContext().poll() | expireTimers()) {
             idleStreak = 0;
         } else {
             idle(idleStreak);
@@ -73,5 +87,9 @@ bool SingleTaskScheduler::isMultiTasking() {
     return false;
 }
 
+bool SingleTaskScheduler::canPark() {
+    return !resumed.load(std::memory_order_seq_cst);
+}
+
 } // namespace detail
 } // namespace fiberize
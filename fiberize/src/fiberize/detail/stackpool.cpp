@@ -0,0 +1,147 @@
+/**
+ * Pools of stacks used by the schedulers.
+ *
+ * @file stackpool.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/stackpool.hpp>
+#include <fiberize/detail/guardedstack.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace fiberize {
+namespace detail {
+
+constexpr size_t StackClasses::minStackSize;
+constexpr size_t StackClasses::count;
+constexpr size_t StackClasses::maxStackSize;
+
+constexpr size_t defaultLowWatermark = 32;
+constexpr size_t defaultHighWatermark = 256;
+
+#if defined(FIBERIZE_SEGMENTED_STACKS)
+using StackAllocator = boost::context::segmented_stack;
+#elif defined(FIBERIZE_GUARDED_STACKS)
+using StackAllocator = GuardedStackAllocator;
+#else
+using StackAllocator = boost::context::fixedsize_stack;
+#endif
+
+size_t StackClasses::classOf(size_t size) {
+    if (size == 0)
+        return defaultClass();
+
+    size_t sizeClass = 0;
+    while (sizeClass + 1 < count && sizeOf(sizeClass) < size)
+        sizeClass += 1;
+    return sizeClass;
+}
+
+size_t StackClasses::defaultClass() {
+    static const size_t sizeClass = classOf(boost::context::stack_traits::default_size());
+    return sizeClass;
+}
+
+GlobalStackPool::GlobalStackPool()
+    : lowWatermark(defaultLowWatermark)
+    , highWatermark(defaultHighWatermark)
+    , capacity(defaultHighWatermark)
+    , lazyRelease(true) {}
+
+GlobalStackPool::~GlobalStackPool() {
+    for (auto& contexts : classes) {
+        for (PooledContext* context : contexts)
+            StackPool::destroy(context);
+    }
+}
+
+void GlobalStackPool::take(size_t sizeClass, std::vector<PooledContext*>& to, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& contexts = classes[sizeClass];
+    n = std::min(n, contexts.size());
+    to.insert(to.end(), contexts.end() - n, contexts.end());
+    contexts.resize(contexts.size() - n);
+}
+
+void GlobalStackPool::give(size_t sizeClass, std::vector<PooledContext*>& from, size_t n) {
+    assert(n <= from.size());
+    size_t kept;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& contexts = classes[sizeClass];
+        size_t limit = capacity.load(std::memory_order_relaxed);
+        kept = contexts.size() < limit ? std::min(n, limit - contexts.size()) : 0;
+        contexts.insert(contexts.end(), from.end() - n, from.end() - n + kept);
+    }
+
+    // Free the rest outside of the lock, unmapping stacks is slow.
+    for (auto it = from.end() - n + kept; it != from.end(); ++it)
+        StackPool::destroy(*it);
+    from.resize(from.size() - n);
+}
+
+StackPool::StackPool(GlobalStackPool* global, void (*entry)(intptr_t))
+    : global(global), entry(entry) {}
+
+StackPool::~StackPool() {
+    clear();
+}
+
+PooledContext* StackPool::get(size_t sizeClass) {
+    auto& contexts = classes[sizeClass];
+    if (contexts.empty())
+        global->take(sizeClass, contexts, std::max<size_t>(global->lowWatermark.load(std::memory_order_relaxed), 1));
+
+    if (contexts.empty())
+        return create(sizeClass, entry);
+
+    PooledContext* context = contexts.back();
+    contexts.pop_back();
+    return context;
+}
+
+void StackPool::put(PooledContext* context) {
+    assert(context != nullptr);
+    auto& contexts = classes[context->sizeClass];
+    size_t high = global->highWatermark.load(std::memory_order_relaxed);
+    size_t low = std::min(global->lowWatermark.load(std::memory_order_relaxed), high);
+
+#ifdef FIBERIZE_GUARDED_STACKS
+    // Keep the pages of the hot stacks, give the rest back to the kernel. The context is saved
+    // on the stack, everything below it is garbage.
+    if (contexts.size() >= low)
+        GuardedStackAllocator::release(context->stack, context->context,
+                                       global->lazyRelease.load(std::memory_order_relaxed));
+#endif
+
+    contexts.push_back(context);
+    if (contexts.size() > high)
+        global->give(context->sizeClass, contexts, contexts.size() - low);
+}
+
+void StackPool::clear() {
+    for (auto& contexts : classes) {
+        for (PooledContext* context : contexts)
+            destroy(context);
+        contexts.clear();
+    }
+}
+
+PooledContext* StackPool::create(size_t sizeClass, void (*entry)(intptr_t)) {
+    StackAllocator allocator(StackClasses::sizeOf(sizeClass));
+    PooledContext* context = new PooledContext;
+    context->sizeClass = sizeClass;
+    context->stack = allocator.allocate();
+    context->context = boost::context::make_fcontext(context->stack.sp, context->stack.size, entry);
+    return context;
+}
+
+void StackPool::destroy(PooledContext* context) {
+    StackAllocator allocator(StackClasses::sizeOf(context->sizeClass));
+    allocator.deallocate(context->stack);
+    delete context;
+}
+
+} // namespace detail
+} // namespace fiberize
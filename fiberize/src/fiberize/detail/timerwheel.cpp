@@ -0,0 +1,175 @@
+/**
+ * Hierarchical timing wheel.
+ *
+ * @file timerwheel.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/timerwheel.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace fiberize {
+namespace detail {
+
+constexpr size_t TimerWheel::levelBits;
+constexpr size_t TimerWheel::slots;
+constexpr size_t TimerWheel::levels;
+constexpr uint64_t TimerWheel::never;
+
+TimerWheel::TimerWheel()
+    : elapsed(now()), count(0), cancelled(nullptr) {
+    occupied.fill(0);
+    for (auto& level : lists)
+        level.fill(nullptr);
+}
+
+uint64_t TimerWheel::now() {
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+}
+
+uint64_t TimerWheel::deadlineOf(std::chrono::steady_clock::time_point time) {
+    auto sinceEpoch = time.time_since_epoch();
+    if (sinceEpoch.count() <= 0)
+        return 0;
+
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(sinceEpoch);
+    if (milliseconds < sinceEpoch)
+        milliseconds += std::chrono::milliseconds(1);
+    return milliseconds.count();
+}
+
+void TimerWheel::schedule(Timer* timer, uint64_t deadline) {
+    assert(!timer->scheduled);
+    timer->deadline = deadline;
+    link(timer);
+    count += 1;
+}
+
+void TimerWheel::cancel(Timer* timer) {
+    if (!timer->scheduled)
+        return;
+
+    unlink(timer);
+    count -= 1;
+}
+
+void TimerWheel::cancelConcurrent(Timer* timer) {
+    Timer* head = cancelled.load(std::memory_order_relaxed);
+    do {
+        timer->nextCancelled = head;
+    } while (!cancelled.compare_exchange_weak(head, timer, std::memory_order_release,
+                                              std::memory_order_relaxed));
+}
+
+void TimerWheel::collectCancelled() {
+    if (cancelled.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    Timer* timer = cancelled.exchange(nullptr, std::memory_order_acquire);
+    while (timer != nullptr) {
+        Timer* next = timer->nextCancelled;
+        bool removed = timer->scheduled;
+        cancel(timer);
+        timer->withdrawn(timer, removed);
+        timer = next;
+    }
+}
+
+size_t TimerWheel::advance(uint64_t time) {
+    size_t expired = 0;
+
+    while (count != 0) {
+        size_t level, slot;
+        uint64_t next = nextExpiration(level, slot);
+        if (next > time)
+            break;
+
+        elapsed = next;
+        while (Timer* timer = lists[level][slot]) {
+            unlink(timer);
+            if (level == 0) {
+                count -= 1;
+                expired += 1;
+                timer->expired(timer);
+            } else {
+                // Move the timer closer, relative to the new time.
+                link(timer);
+            }
+        }
+    }
+
+    elapsed = std::max(elapsed, time);
+    return expired;
+}
+
+uint64_t TimerWheel::nextExpiration() const {
+    size_t level, slot;
+    return nextExpiration(level, slot);
+}
+
+uint64_t TimerWheel::nextExpiration(size_t& level, size_t& slot) const {
+    for (level = 0; level < levels; ++level) {
+        if (occupied[level] == 0)
+            continue;
+
+        // Timers never lie behind the current position of their level, see link().
+        size_t shift = level * levelBits;
+        size_t position = (elapsed >> shift) & (slots - 1);
+        uint64_t ahead = occupied[level] & (~uint64_t(0) << position);
+        assert(ahead != 0);
+        slot = size_t(__builtin_ctzll(ahead));
+
+        uint64_t windowStart = 0;
+        if (shift + levelBits < 64)
+            windowStart = elapsed & ~((uint64_t(1) << (shift + levelBits)) - 1);
+        return windowStart + (uint64_t(slot) << shift);
+    }
+
+    return never;
+}
+
+void TimerWheel::link(Timer* timer) {
+    // The level is given by the highest bit in which the deadline differs from the current time.
+    // The deadline agrees with the time on all higher bits, so it's in the current window of
+    // the level and at or after the current slot.
+    uint64_t deadline = std::max(timer->deadline, elapsed);
+    uint64_t differing = (deadline ^ elapsed) | (slots - 1);
+    size_t level = size_t(63 - __builtin_clzll(differing)) / levelBits;
+    size_t slot = size_t(deadline >> (level * levelBits)) & (slots - 1);
+
+    Timer*& head = lists[level][slot];
+    timer->prev = nullptr;
+    timer->next = head;
+    if (head != nullptr)
+        head->prev = timer;
+    head = timer;
+
+    timer->level = uint8_t(level);
+    timer->slot = uint8_t(slot);
+    timer->scheduled = true;
+    occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    Timer*& head = lists[timer->level][timer->slot];
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        head = timer->next;
+    }
+    if (timer->next != nullptr)
+        timer->next->prev = timer->prev;
+
+    if (head == nullptr)
+        occupied[timer->level] &= ~(uint64_t(1) << timer->slot);
+
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->scheduled = false;
+}
+
+} // namespace detail
+} // namespace fiberize
@@ -0,0 +1,168 @@
+/**
+ * CPU topology discovery.
+ *
+ * @file topology.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/detail/topology.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace fiberize {
+namespace detail {
+
+static const std::string sysfsRoot = "/sys/devices/system/cpu";
+
+static bool readNumber(const std::string& path, uint32_t& value) {
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+
+/**
+ * The node of a CPU is given by a "nodeN" entry in its sysfs directory.
+ */
+static uint32_t readNode(const std::string& cpuDir) {
+    uint32_t node = 0;
+    std::string path = cpuDir;
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return node;
+
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0
+            && std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            node = uint32_t(std::stoul(name.substr(4)));
+            break;
+        }
+    }
+
+    closedir(dir);
+    return node;
+}
+
+Distance distance(const CpuLocation& a, const CpuLocation& b) {
+    if (a.node != b.node) {
+        return Distance::Remote;
+    } else if (a.package == b.package && a.core == b.core) {
+        return Distance::SameCore;
+    } else if (a.package == b.package) {
+        return Distance::SamePackage;
+    } else {
+        return Distance::SameNode;
+    }
+}
+
+std::array<std::vector<size_t>, distanceLevels> neighbours(const std::vector<CpuLocation>& locations, size_t self) {
+    std::array<std::vector<size_t>, distanceLevels> levels;
+    for (size_t i = 0; i < locations.size(); ++i) {
+        if (i != self)
+            levels[size_t(distance(locations[self], locations[i]))].push_back(i);
+    }
+    return levels;
+}
+
+Topology Topology::detect() {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    std::vector<uint32_t> allowed;
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask))
+                allowed.push_back(cpu);
+        }
+    }
+
+    return read(sysfsRoot, allowed);
+}
+
+Topology Topology::read(const std::string& root, const std::vector<uint32_t>& allowed) {
+    Topology topology;
+
+    bool haveMask = !allowed.empty();
+    std::vector<uint32_t> candidates = allowed;
+    if (!haveMask) {
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            candidates.push_back(cpu);
+    }
+
+    for (uint32_t cpu : candidates) {
+        CpuLocation location;
+        location.cpu = cpu;
+        std::string cpuDir = root + "/cpu" + std::to_string(cpu);
+        std::string topologyDir = cpuDir + "/topology/";
+        if (!readNumber(topologyDir + "core_id", location.core)
+            || !readNumber(topologyDir + "physical_package_id", location.package)) {
+            // No sysfs, pretend that every CPU is a separate core.
+            if (haveMask) {
+                location.core = cpu;
+                location.package = 0;
+            } else {
+                continue;
+            }
+        }
+        location.node = readNode(cpuDir);
+        topology.cpus_.push_back(location);
+    }
+
+    // Without an affinity mask and sysfs fall back to the number of hardware threads.
+    if (topology.cpus_.empty()) {
+        uint32_t n = std::max(std::thread::hardware_concurrency(), 1u);
+        for (uint32_t cpu = 0; cpu < n; ++cpu)
+            topology.cpus_.push_back(CpuLocation{cpu, cpu, 0, 0});
+    }
+
+    // Number the hardware threads of each core, so that we can use every physical core once
+    // before using the second hardware thread of any core.
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> threadsPerCore;
+    std::vector<uint32_t> rank;
+    for (const CpuLocation& location : topology.cpus_)
+        rank.push_back(threadsPerCore[std::make_pair(location.package, location.core)]++);
+
+    std::vector<size_t> order(topology.cpus_.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    const auto& cpus = topology.cpus_;
+    std::stable_sort(order.begin(), order.end(), [&] (size_t a, size_t b) {
+        return std::tie(rank[a], cpus[a].node, cpus[a].package, cpus[a].core)
+            < std::tie(rank[b], cpus[b].node, cpus[b].package, cpus[b].core);
+    });
+
+    std::vector<CpuLocation> sorted;
+    for (size_t i : order)
+        sorted.push_back(cpus[i]);
+    topology.cpus_ = std::move(sorted);
+
+    return topology;
+}
+
+uint32_t Topology::nodes() const {
+    uint32_t nodes = 1;
+    for (const CpuLocation& location : cpus_)
+        nodes = std::max(nodes, location.node + 1);
+    return nodes;
+}
+
+bool pinThisThread(uint32_t cpu) {
+    if (cpu >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace detail
+} // namespace fiberize
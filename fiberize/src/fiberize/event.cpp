@@ -16,4 +16,16 @@ void Event<void>::await() const {
     context::processUntil(condition);
 }
 
+template <>
+bool Event<void>::awaitUntil(std::chrono::steady_clock::time_point deadline) const {
+    bool condition = false;
+
+    HandlerRef handler = bind([&] () {
+        condition = true;
+        handler.release();
+    });
+
+    return context::processUntil(condition, deadline);
+}
+
 } // namespace fiberize
@@ -0,0 +1,58 @@
+/**
+ * Interned event identifiers.
+ *
+ * @file eventid.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/eventid.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace fiberize {
+namespace detail {
+
+namespace {
+
+struct EventRegistry {
+    std::mutex mutex;
+    std::unordered_map<Path, EventId, boost::hash<Path>> ids;
+    EventId nextId = devNullEventId + 1;
+};
+
+/**
+ * The registry is used by static events, so it must be initialized on first use.
+ */
+EventRegistry& registry() {
+    static EventRegistry instance;
+    return instance;
+}
+
+} // namespace
+
+EventId internEvent(const Path& path) {
+    if (boost::get<DevNullPath>(&path) != nullptr)
+        return devNullEventId;
+
+    // Unique global paths don't need the registry, unless the token clashes with interned ids.
+    if (const GlobalPath* global = boost::get<GlobalPath>(&path)) {
+        Ident ident = global->ident();
+        if (const UniqueIdent* unique = boost::get<UniqueIdent>(&ident)) {
+            if ((unique->token() & internedEventBit) == 0)
+                return unique->token();
+        }
+    }
+
+    EventRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.ids.find(path);
+    if (it != reg.ids.end())
+        return it->second;
+
+    EventId id = reg.nextId++;
+    reg.ids.emplace(path, id);
+    return id;
+}
+
+} // namespace detail
+} // namespace fiberize
@@ -10,4 +10,8 @@ NullAwaitable::NullAwaitable()
     : runtime_error("The awaitable will never yield a value")
     {}
 
+MailboxFull::MailboxFull()
+    : runtime_error("The mailbox is full")
+    {}
+
 } // namespace fiberize
@@ -1,19 +1,43 @@
 #include <fiberize/fiberref.hpp>
+#include <fiberize/fiberref-inl.hpp>
 #include <fiberize/event.hpp>
-#include <fiberize/detail/devnullfiberref.hpp>
 
 namespace fiberize {
 
-FiberRef::FiberRef() : impl_(std::shared_ptr<detail::FiberRefImpl>(), &detail::devNullFiberRef) {}
+constexpr uintptr_t FiberRef::taskTag;
+constexpr uintptr_t FiberRef::implTag;
+constexpr uintptr_t FiberRef::tagMask;
+
+Locality FiberRef::locality() const {
+    if (ref_ == 0) {
+        return DevNull;
+    } else if ((ref_ & tagMask) == taskTag) {
+        return Local;
+    } else {
+        return impl()->locality();
+    }
+}
+
+Path FiberRef::path() const {
+    if (ref_ == 0) {
+        return DevNullPath{};
+    } else if ((ref_ & tagMask) == taskTag) {
+        return task()->path;
+    } else {
+        return impl()->path();
+    }
+}
 
 template <>
 void FiberRef::send<void>(const Event<void>& event) const {
-    if (impl_->locality() != DevNull && event.path() != Path(DevNullPath{})) {
+    if (ref_ != 0 && event.id() != detail::devNullEventId) {
         PendingEvent pendingEvent;
-        pendingEvent.path = event.path();
-        pendingEvent.data = nullptr;
-        pendingEvent.freeData = nullptr;
-        impl_->send(pendingEvent);
+        pendingEvent.id = event.id();
+        if ((ref_ & tagMask) == taskTag) {
+            context::detail::deliver(task(), std::move(pendingEvent));
+        } else {
+            impl()->send(std::move(pendingEvent));
+        }
     }
 }
 
@@ -11,8 +11,13 @@ namespace fiberize {
 
 FiberSystem::FiberSystem() : FiberSystem(std::thread::hardware_concurrency()) {}
 
-FiberSystem::FiberSystem(uint32_t macrothreads)
+FiberSystem::FiberSystem(uint32_t macrothreads, bool pinThreads)
     : shuttingDown_(false)
+    , ioPollInterval_(std::chrono::nanoseconds(std::chrono::milliseconds(10)).count())
+    , sleepers_(0)
+    , searching_(0)
+    , offloadPool_(new detail::OffloadPool)
+    , osThreadPool_(new detail::OSThreadPool(this))
 #ifdef FIBERIZE_VALGRIND
     , seedGenerator(std::chrono::system_clock::now().time_since_epoch().count())
 #endif
@@ -25,9 +30,22 @@ FiberSystem::FiberSystem(uint32_t macrothreads)
     boost::uuids::random_generator uuidGenerator(pseudorandom);
     uuid_ = uuidGenerator();
 
+    // Assign the schedulers to CPUs and create a stack pool for every node.
+    detail::Topology topology = detail::Topology::detect();
+    const auto& cpus = topology.cpus();
+    std::vector<uint32_t> schedulersOnNode(topology.nodes(), 0);
+    for (uint32_t i = 0; i < macrothreads; ++i)
+        schedulersOnNode[cpus[i % cpus.size()].node] += 1;
+
+    for (uint32_t node = 0; node < topology.nodes(); ++node) {
+        stackPools_.emplace_back(new detail::GlobalStackPool);
+        stackPools_.back()->capacity = stackPools_.back()->highWatermark * schedulersOnNode[node];
+    }
+
     // Spawn the schedulers.
     for (uint32_t i = 0; i < macrothreads; ++i) {
-        schedulers_.emplace_back(new detail::MultiTaskScheduler(this, seedDist(seedGenerator)));
+        schedulers_.emplace_back(new detail::MultiTaskScheduler(
+            this, seedDist(seedGenerator), cpus[i % cpus.size()], pinThreads));
     }
 
     for (uint32_t i = 0; i < macrothreads; ++i) {
@@ -36,6 +54,10 @@ FiberSystem::FiberSystem(uint32_t macrothreads)
 }
 
 FiberSystem::~FiberSystem() {
+    // Offloaded calls resume their fibers, finish them while the schedulers are alive.
+    offloadPool_.reset();
+    osThreadPool_.reset();
+
     for (auto scheduler : schedulers_) {
         scheduler->stop();
     }
@@ -55,5 +77,41 @@ bool FiberSystem::shuttingDown() const {
 boost::uuids::uuid FiberSystem::uuid() const {
     return uuid_;
 }
+
+void FiberSystem::ioPollInterval(std::chrono::nanoseconds interval) {
+    ioPollInterval_.store(interval.count(), std::memory_order_relaxed);
+}
+
+void FiberSystem::stackPoolWatermarks(size_t low, size_t high) {
+    std::vector<size_t> schedulersOnNode(stackPools_.size(), 0);
+    for (detail::MultiTaskScheduler* scheduler : schedulers_)
+        schedulersOnNode[scheduler->location().node] += 1;
+
+    for (size_t node = 0; node < stackPools_.size(); ++node) {
+        stackPools_[node]->lowWatermark.store(low, std::memory_order_relaxed);
+        stackPools_[node]->highWatermark.store(high, std::memory_order_relaxed);
+        stackPools_[node]->capacity.store(high * schedulersOnNode[node], std::memory_order_relaxed);
+    }
+}
+
+void FiberSystem::offloadThreads(size_t maxThreads) {
+    offloadPool_->maxThreads(maxThreads);
+}
+
+void FiberSystem::offloadIdleTimeout(std::chrono::nanoseconds timeout) {
+    offloadPool_->idleTimeout(timeout);
+}
+
+OffloadStats FiberSystem::offloadStats() {
+    return offloadPool_->stats();
+}
+
+void FiberSystem::osThreadIdleLimit(size_t maxIdle) {
+    osThreadPool_->maxIdle(maxIdle);
+}
+
+void FiberSystem::osThreadIdleTimeout(std::chrono::nanoseconds timeout) {
+    osThreadPool_->idleTimeout(timeout);
+}
     
 } // namespace fiberize
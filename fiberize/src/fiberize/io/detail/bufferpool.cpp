@@ -0,0 +1,142 @@
+/**
+ * Per-scheduler pool of IO buffers.
+ *
+ * @file bufferpool.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/detail/bufferpool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+constexpr size_t BufferClasses::minBufferSize;
+constexpr size_t BufferClasses::count;
+constexpr size_t BufferClasses::maxBufferSize;
+
+/**
+ * Size of the memory allocated at once for buffers of a class.
+ */
+constexpr size_t slabSize = 256 * 1024;
+
+size_t BufferClasses::classOf(size_t size) {
+    size_t sizeClass = 0;
+    while (sizeClass < count && sizeOf(sizeClass) < size)
+        sizeClass += 1;
+    return sizeClass;
+}
+
+void BufferBlock::release(BufferBlock* block) {
+    if (block->pool != nullptr) {
+        block->pool->recycle(block);
+    } else {
+        std::free(block);
+    }
+}
+
+BufferPool::BufferPool() : references(1), detached(false), returned(nullptr) {
+    std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+}
+
+BufferPool::~BufferPool() {
+    for (void* slab : slabs)
+        std::free(slab);
+}
+
+BufferBlock* BufferPool::allocate(size_t size) {
+    size_t sizeClass = BufferClasses::classOf(size);
+    if (sizeClass == BufferClasses::count)
+        return allocateUnpooled(size);
+
+    if (freeLists[sizeClass] == nullptr) {
+        collect();
+        if (freeLists[sizeClass] == nullptr)
+            refill(sizeClass);
+    }
+
+    BufferBlock* block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->next;
+    block->references.store(1, std::memory_order_relaxed);
+    references.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+BufferBlock* BufferPool::allocateUnpooled(size_t size) {
+    void* memory;
+    if (posix_memalign(&memory, cacheLineSize, sizeof(BufferBlock) + size) != 0)
+        throw std::bad_alloc();
+
+    BufferBlock* block = new (memory) BufferBlock;
+    block->references.store(1, std::memory_order_relaxed);
+    block->sizeClass = BufferClasses::count;
+    block->capacity = size;
+    block->pool = nullptr;
+    block->next = nullptr;
+    return block;
+}
+
+void BufferPool::detach() {
+    detached.store(true, std::memory_order_relaxed);
+    drop();
+}
+
+void BufferPool::recycle(BufferBlock* block) {
+    if (!detached.load(std::memory_order_relaxed)
+        && owner.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+        block->next = freeLists[block->sizeClass];
+        freeLists[block->sizeClass] = block;
+    } else {
+        BufferBlock* head = returned.load(std::memory_order_relaxed);
+        do {
+            block->next = head;
+        } while (!returned.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    drop();
+}
+
+void BufferPool::collect() {
+    BufferBlock* block = returned.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        BufferBlock* next = block->next;
+        block->next = freeLists[block->sizeClass];
+        freeLists[block->sizeClass] = block;
+        block = next;
+    }
+}
+
+void BufferPool::refill(size_t sizeClass) {
+    owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    size_t blockSize = sizeof(BufferBlock) + BufferClasses::sizeOf(sizeClass);
+    size_t blocks = std::max<size_t>(slabSize / blockSize, 1);
+
+    void* slab;
+    if (posix_memalign(&slab, cacheLineSize, blocks * blockSize) != 0)
+        throw std::bad_alloc();
+    slabs.push_back(slab);
+
+    char* memory = reinterpret_cast<char*>(slab);
+    for (size_t i = 0; i < blocks; ++i) {
+        BufferBlock* block = new (memory + i * blockSize) BufferBlock;
+        block->sizeClass = uint32_t(sizeClass);
+        block->capacity = BufferClasses::sizeOf(sizeClass);
+        block->pool = this;
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+}
+
+void BufferPool::drop() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
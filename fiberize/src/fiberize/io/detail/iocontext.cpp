@@ -6,7 +6,9 @@
 #include <fiberize/fibersystem.hpp>
 #include <fiberize/builder-inl.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <system_error>
 #include <thread>
 
 using namespace std::literals;
@@ -16,36 +18,78 @@ namespace io {
 namespace detail {
 
 /**
- * 10 milliseconds.
+ * 50 microseconds.
  */
-const uint64_t timeInterval = 1000 * 1000 * 10;
+const uint64_t minInterval = 1000 * 50;
 
-IOContext::IOContext() {
+IOContext::IOContext() : poller_(this), bufferPool_(new BufferPool) {
+#ifdef FIBERIZE_IO_URING
+    ringUnavailable_ = false;
+#endif
     lastRun = 0;
+    interval = minInterval;
+    completions = 0;
     uv_loop_init(loop());
 }
 
 IOContext::~IOContext() {
+    // Buffers can still be used by other threads, the pool deletes itself after they are released.
+    bufferPool_->detach();
+#ifdef FIBERIZE_IO_URING
+    ring_.reset();
+#endif
     uv_loop_close(loop());
 }
 
 bool IOContext::poll() {
+    uint64_t before = completions;
     lastRun = uv_hrtime_fast();
-    return uv_run(loop(), UV_RUN_NOWAIT);
+    uv_run(loop(), UV_RUN_NOWAIT);
+    return completions != before;
 }
 
-void IOContext::throttledPoll() {
+void IOContext::throttledPoll(uint64_t maxInterval) {
+    // Nothing can complete if nothing is in flight.
+    if (!active())
+        return;
+
     uint64_t time = uv_hrtime_fast();
-    if (time - lastRun > timeInterval) {
-        lastRun = time;
-        uv_run(loop(), UV_RUN_NOWAIT);
+    if (time - lastRun > interval) {
+        if (poll()) {
+            interval = std::max(interval / 2, minInterval);
+        } else {
+            interval = std::min(interval * 2, maxInterval);
+        }
     }
 }
 
+bool IOContext::active() {
+    return uv_loop_alive(loop());
+}
+
 uv_loop_t* IOContext::loop() {
     return &loop_;
 }
 
+#ifdef FIBERIZE_IO_URING
+/**
+ * Number of submission queue entries.
+ */
+const unsigned ringEntries = 256;
+
+Ring* IOContext::ring() {
+    if (!ring_ && !ringUnavailable_) {
+        try {
+            ring_.reset(new Ring(this, ringEntries));
+        } catch (const std::system_error&) {
+            // Old kernel or forbidden by seccomp.
+            ringUnavailable_ = true;
+        }
+    }
+    return ring_.get();
+}
+#endif
+
 } // namespace detail
 } // namespace io
 } // namespace fiberize
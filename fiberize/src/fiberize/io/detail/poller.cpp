@@ -0,0 +1,181 @@
+/**
+ * Readiness notifications for file descriptors.
+ *
+ * @file poller.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/detail/poller.hpp>
+#include <fiberize/io/detail/iocontext.hpp>
+#include <fiberize/context.hpp>
+#include <fiberize/scheduler.hpp>
+#include <fiberize/scopedpin.hpp>
+#include <fiberize/detail/task.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <system_error>
+
+#include <poll.h>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+Poller::Poller(IOContext* context) : context(context) {}
+
+void Poller::add(int fd, PollWaiter* waiter) {
+    Watch*& watch = watches[fd];
+    if (watch == nullptr) {
+        watch = new Watch;
+        int code = uv_poll_init(context->loop(), &watch->handle, fd);
+        if (code < 0) {
+            delete watch;
+            watches.erase(fd);
+            throw std::system_error(-code, std::system_category());
+        }
+
+        watch->handle.data = watch;
+        watch->fd = fd;
+        watch->waiters = nullptr;
+        watch->poller = this;
+    }
+
+    waiter->prev = nullptr;
+    waiter->next = watch->waiters;
+    if (watch->waiters != nullptr)
+        watch->waiters->prev = waiter;
+    watch->waiters = waiter;
+    update(watch);
+}
+
+void Poller::remove(int fd, PollWaiter* waiter) {
+    auto it = watches.find(fd);
+    assert(it != watches.end());
+    Watch* watch = it->second;
+
+    if (waiter->prev != nullptr) {
+        waiter->prev->next = waiter->next;
+    } else {
+        watch->waiters = waiter->next;
+    }
+    if (waiter->next != nullptr)
+        waiter->next->prev = waiter->prev;
+
+    update(watch);
+}
+
+void Poller::update(Watch* watch) {
+    int events = 0;
+    for (PollWaiter* waiter = watch->waiters; waiter != nullptr; waiter = waiter->next)
+        events |= waiter->events;
+
+    if (events != 0) {
+        uv_poll_start(&watch->handle, events, callback);
+    } else {
+        // Nobody is waiting. Close the handle, the descriptor could be closed soon.
+        watches.erase(watch->fd);
+        uv_close(reinterpret_cast<uv_handle_t*>(&watch->handle), [] (uv_handle_t* handle) {
+            delete reinterpret_cast<Watch*>(handle->data);
+        });
+    }
+}
+
+void Poller::callback(uv_poll_t* handle, int status, int events) {
+    Watch* watch = reinterpret_cast<Watch*>(handle->data);
+    Poller* poller = watch->poller;
+    poller->context->recordCompletion();
+
+    // Take the waiters that are ready before calling them, they can add themselves again.
+    PollWaiter* ready = nullptr;
+    PollWaiter* waiter = watch->waiters;
+    while (waiter != nullptr) {
+        PollWaiter* next = waiter->next;
+        if (status < 0 || (waiter->events & events) != 0) {
+            if (waiter->prev != nullptr) {
+                waiter->prev->next = next;
+            } else {
+                watch->waiters = next;
+            }
+            if (next != nullptr)
+                next->prev = waiter->prev;
+
+            waiter->next = ready;
+            ready = waiter;
+        }
+        waiter = next;
+    }
+
+    // This can close the handle, the watch must not be touched after it.
+    poller->update(watch);
+
+    while (ready != nullptr) {
+        PollWaiter* next = ready->next;
+        ready->ready(ready, status);
+        ready = next;
+    }
+}
+
+namespace {
+
+/**
+ * A fiber waiting on its stack. It's pinned, so the poller is always used from the right thread.
+ */
+struct AwaitWaiter : public PollWaiter {
+    static void callback(PollWaiter* waiter, int status) {
+        auto self = static_cast<AwaitWaiter*>(waiter);
+        std::unique_lock<Spinlock> lock(self->task->spinlock);
+        self->status = status;
+        self->condition = true;
+        context::detail::resume(self->task, std::move(lock));
+    }
+
+    fiberize::detail::Task* task;
+    int status;
+    bool condition;
+};
+
+} // namespace
+
+void awaitReady(int fd, int events) {
+    ScopedPin pin;
+    Poller& poller = Scheduler::current()->ioContext().poller();
+
+    AwaitWaiter waiter;
+    waiter.events = events;
+    waiter.ready = AwaitWaiter::callback;
+    waiter.task = context::detail::task();
+    waiter.status = 0;
+    waiter.condition = false;
+    poller.add(fd, &waiter);
+
+    try {
+        context::processUntil(waiter.condition);
+    } catch (...) {
+        // A handler threw, stop waiting.
+        if (!waiter.condition)
+            poller.remove(fd, &waiter);
+        throw;
+    }
+
+    if (waiter.status < 0)
+        throw std::system_error(-waiter.status, std::system_category());
+}
+
+void blockReady(int fd, int events) {
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = 0;
+    if (events & UV_READABLE)
+        pfd.events |= POLLIN;
+    if (events & UV_WRITABLE)
+        pfd.events |= POLLOUT;
+
+    while (::poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR)
+            throw std::system_error(errno, std::system_category());
+    }
+}
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
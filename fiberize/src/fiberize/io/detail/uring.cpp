@@ -0,0 +1,276 @@
+/**
+ * Linux io_uring submission and completion rings.
+ *
+ * @file uring.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/detail/uring.hpp>
+
+#ifdef FIBERIZE_IO_URING
+
+#include <fiberize/io/detail/iocontext.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <system_error>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+namespace {
+
+int setup(unsigned entries, io_uring_params* params) {
+    return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int enter(int fd, unsigned submit, unsigned complete, unsigned flags) {
+    return int(syscall(__NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0));
+}
+
+int registerProbe(int fd, io_uring_probe* probe, unsigned ops) {
+    return int(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops));
+}
+
+/**
+ * Checks whether the kernel supports all the given operations. Kernels without probing support
+ * don't have IORING_OP_READ and IORING_OP_WRITE either.
+ */
+bool supports(int fd, std::initializer_list<uint8_t> opcodes) {
+    const unsigned ops = 256;
+    std::vector<char> memory(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+    if (registerProbe(fd, probe, ops) < 0)
+        return false;
+
+    for (uint8_t opcode : opcodes) {
+        if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+T* offset(void* base, uint32_t bytes) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(base) + bytes);
+}
+
+} // namespace
+
+Ring::Ring(IOContext* context, unsigned entries)
+    : context(context), poll(nullptr), polling(false), inflight(0), queued(0) {
+    sqRing = MAP_FAILED;
+    sqes = reinterpret_cast<io_uring_sqe*>(MAP_FAILED);
+    cqRing = MAP_FAILED;
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = setup(entries, &params);
+    if (fd < 0)
+        throw std::system_error(errno, std::system_category());
+
+    try {
+        // Reads and writes at an offset appeared after the ring itself.
+        if (!supports(fd, {IORING_OP_READ, IORING_OP_WRITE}))
+            throw std::system_error(ENOSYS, std::system_category());
+
+        // Without NODROP completions are lost when more operations are in flight than the
+        // completion queue holds. Every kernel with the operations above has it.
+        if (!(params.features & IORING_FEAT_NODROP))
+            throw std::system_error(ENOSYS, std::system_category());
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+            throw std::system_error(errno, std::system_category());
+
+        if (single) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+                throw std::system_error(errno, std::system_category());
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* entriesMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (entriesMemory == MAP_FAILED)
+            throw std::system_error(errno, std::system_category());
+        sqes = reinterpret_cast<io_uring_sqe*>(entriesMemory);
+
+        sqHead = offset<unsigned>(sqRing, params.sq_off.head);
+        sqTail = offset<unsigned>(sqRing, params.sq_off.tail);
+        sqMask = *offset<unsigned>(sqRing, params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        sqArray = offset<unsigned>(sqRing, params.sq_off.array);
+
+        cqHead = offset<unsigned>(cqRing, params.cq_off.head);
+        cqTail = offset<unsigned>(cqRing, params.cq_off.tail);
+        cqMask = *offset<unsigned>(cqRing, params.cq_off.ring_mask);
+        cqes = offset<io_uring_cqe>(cqRing, params.cq_off.cqes);
+
+        poll = new uv_poll_t;
+        int code = uv_poll_init(context->loop(), poll, fd);
+        if (code < 0) {
+            delete poll;
+            poll = nullptr;
+            throw std::system_error(-code, std::system_category());
+        }
+        poll->data = this;
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+Ring::~Ring() {
+    close();
+}
+
+void Ring::close() {
+    if (poll != nullptr) {
+        uv_close(reinterpret_cast<uv_handle_t*>(poll), [] (uv_handle_t* handle) {
+            delete reinterpret_cast<uv_poll_t*>(handle);
+        });
+    }
+
+    if (reinterpret_cast<void*>(sqes) != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    ::close(fd);
+}
+
+void Ring::read(int fd, const Buffer& buffer, int64_t offset, RingRequest* request) {
+    io_uring_sqe* sqe = nextEntry();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = uint64_t(offset);
+    sqe->addr = reinterpret_cast<uint64_t>(buffer.data());
+    sqe->len = buffer.length();
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+}
+
+void Ring::write(int fd, const Buffer& buffer, int64_t offset, RingRequest* request) {
+    io_uring_sqe* sqe = nextEntry();
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = uint64_t(offset);
+    sqe->addr = reinterpret_cast<uint64_t>(buffer.data());
+    sqe->len = buffer.length();
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+}
+
+io_uring_sqe* Ring::nextEntry() {
+    if (queued == sqEntries)
+        submit();
+
+    // The kernel consumes the entries during io_uring_enter, so a submitted queue is empty.
+    unsigned tail = *sqTail + queued;
+    unsigned index = tail & sqMask;
+    sqArray[index] = index;
+    queued += 1;
+
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void Ring::submit() {
+    if (queued == 0)
+        return;
+
+    __atomic_store_n(sqTail, *sqTail + queued, __ATOMIC_RELEASE);
+
+    while (queued > 0) {
+        int submitted = enter(fd, queued, 0, 0);
+        if (submitted < 0) {
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN || errno == EBUSY) && inflight > 0) {
+                // The completion queue is full. Wait for a completion and make room.
+                enter(fd, 0, 1, IORING_ENTER_GETEVENTS);
+                reap();
+                continue;
+            }
+
+            failQueued(-errno);
+            break;
+        }
+
+        // Only the entries consumed by the kernel will complete.
+        inflight += unsigned(submitted);
+        queued -= unsigned(submitted);
+    }
+
+    updatePoll();
+}
+
+void Ring::failQueued(int error) {
+    // The kernel doesn't read the ring outside of io_uring_enter, so we can take the entries back.
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail;
+    __atomic_store_n(sqTail, head, __ATOMIC_RELEASE);
+    queued = 0;
+
+    for (; head != tail; ++head) {
+        io_uring_sqe* sqe = &sqes[sqArray[head & sqMask]];
+        RingRequest* request = reinterpret_cast<RingRequest*>(sqe->user_data);
+        request->complete(request, error);
+    }
+}
+
+void Ring::reap() {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        io_uring_cqe* cqe = &cqes[head & cqMask];
+        RingRequest* request = reinterpret_cast<RingRequest*>(cqe->user_data);
+        int result = cqe->res;
+
+        // Free the entry before the callback.
+        head += 1;
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        inflight -= 1;
+        request->complete(request, result);
+
+        tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    }
+}
+
+void Ring::updatePoll() {
+    // Keep the loop alive only while something is in flight.
+    if (inflight > 0 && !polling) {
+        uv_poll_start(poll, UV_READABLE, callback);
+        polling = true;
+    } else if (inflight == 0 && polling) {
+        uv_poll_stop(poll);
+        polling = false;
+    }
+}
+
+void Ring::callback(uv_poll_t* handle, int, int) {
+    Ring* ring = reinterpret_cast<Ring*>(handle->data);
+    ring->reap();
+    ring->updatePoll();
+}
+
+} // namespace detail
+} // namespace io
+} // namespace fiberize
+
+#endif // FIBERIZE_IO_URING
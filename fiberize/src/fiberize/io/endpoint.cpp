@@ -0,0 +1,64 @@
+/**
+ * Socket addresses.
+ *
+ * @file endpoint.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/endpoint.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <uv.h>
+
+namespace fiberize {
+namespace io {
+
+Endpoint::Endpoint() : length(0) {
+    std::memset(&storage, 0, sizeof(storage));
+}
+
+Endpoint::Endpoint(const char* address, uint16_t port) : Endpoint() {
+    if (uv_ip4_addr(address, port, reinterpret_cast<sockaddr_in*>(&storage)) == 0) {
+        length = sizeof(sockaddr_in);
+        return;
+    }
+
+    int code = uv_ip6_addr(address, port, reinterpret_cast<sockaddr_in6*>(&storage));
+    if (code < 0)
+        throw std::system_error(-code, std::system_category());
+    length = sizeof(sockaddr_in6);
+}
+
+Endpoint Endpoint::local(int socket) {
+    Endpoint endpoint;
+    endpoint.length = capacity();
+    if (getsockname(socket, endpoint.data(), &endpoint.length) < 0)
+        throw std::system_error(errno, std::system_category());
+    return endpoint;
+}
+
+uint16_t Endpoint::port() const {
+    if (family() == AF_INET6) {
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(&storage)->sin6_port);
+    } else if (family() == AF_INET) {
+        return ntohs(reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+    } else {
+        return 0;
+    }
+}
+
+std::string Endpoint::address() const {
+    char name[64] = {};
+    if (family() == AF_INET6) {
+        uv_ip6_name(reinterpret_cast<const sockaddr_in6*>(&storage), name, sizeof(name));
+    } else if (family() == AF_INET) {
+        uv_ip4_name(reinterpret_cast<const sockaddr_in*>(&storage), name, sizeof(name));
+    }
+    return name;
+}
+
+} // namespace io
+} // namespace fiberize
@@ -0,0 +1,283 @@
+/**
+ * Batched file IO.
+ *
+ * @file filebatch.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/filebatch.hpp>
+#include <fiberize/io/detail/iocontext.hpp>
+#include <fiberize/context.hpp>
+#include <fiberize/scheduler.hpp>
+#include <fiberize/detail/refrencecounted.hpp>
+#include <fiberize/detail/task.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <system_error>
+
+namespace fiberize {
+namespace io {
+
+constexpr size_t FileBatch::none;
+
+namespace detail {
+
+struct FileOperation
+#ifdef FIBERIZE_IO_URING
+    : public RingRequest
+#endif
+{
+    FileOperation(FileBatchEnv* env, size_t index, int fd, const Buffer& buffer, int64_t offset, bool write)
+        : env(env), index(index), fd(fd), buffer(buffer), offset(offset), write(write), result(0)
+        , done(false), released(false) {}
+
+    uv_fs_t request;
+    FileBatchEnv* env;
+    size_t index;
+    int fd;
+    Buffer buffer;
+    int64_t offset;
+    bool write;
+    ssize_t result;
+    bool done;
+    bool released;
+
+    /**
+     * Keeps a pooled buffer alive while the operation is in flight.
+     */
+    PooledBuffer owner;
+};
+
+/**
+ * State shared by the batch and its operations in flight. It's only used on the thread running
+ * the scheduler the batch was created on.
+ */
+struct FileBatchEnv : public fiberize::detail::ReferenceCounted {
+    FileBatchEnv() {
+        scheduler = context::scheduler();
+        task = context::detail::task();
+        task->grab();
+        first = 0;
+        submitted = 0;
+        inflight = 0;
+        ready = false;
+        idle = true;
+    }
+
+    virtual ~FileBatchEnv() {
+        task->drop();
+    }
+
+    /**
+     * Records the result of an operation and wakes up the fiber. Drops the reference held by
+     * the operation.
+     */
+    void complete(FileOperation* operation, ssize_t result) {
+        scheduler->ioContext().recordCompletion();
+        operation->result = result;
+        operation->owner = PooledBuffer();
+        completed.push_back(operation->index);
+        inflight -= 1;
+
+        {
+            std::unique_lock<Spinlock> lock(task->spinlock);
+            operation->done = true;
+            ready = true;
+            idle = inflight == 0;
+            context::detail::resume(task, std::move(lock));
+        }
+
+        drop();
+    }
+
+    static void uvCallback(uv_fs_t* request) {
+        auto operation = reinterpret_cast<FileOperation*>(request->data);
+        ssize_t result = request->result;
+        uv_fs_req_cleanup(request);
+        operation->env->complete(operation, result);
+    }
+
+#ifdef FIBERIZE_IO_URING
+    static void ringCallback(RingRequest* request, int result) {
+        auto operation = static_cast<FileOperation*>(request);
+        operation->env->complete(operation, result);
+    }
+#endif
+
+    /**
+     * Returns the operation with the given index.
+     */
+    FileOperation& operation(size_t index) {
+        assert(index >= first && index < first + operations.size());
+        return operations[index - first];
+    }
+
+    /**
+     * Queues an operation and returns its index.
+     */
+    size_t queue(int fd, const Buffer& buffer, int64_t offset, bool write) {
+        size_t index = first + operations.size();
+        operations.emplace_back(this, index, fd, buffer, offset, write);
+        return index;
+    }
+
+    /**
+     * Removes an operation from the completion queue, if it's there.
+     */
+    void unqueue(size_t index) {
+        auto it = std::find(completed.begin(), completed.end(), index);
+        if (it != completed.end())
+            completed.erase(it);
+        ready = !completed.empty();
+    }
+
+    Scheduler* scheduler;
+    fiberize::detail::Task* task;
+
+    /**
+     * Operations that were not released yet, starting with the one with index first.
+     */
+    std::deque<FileOperation> operations;
+    std::deque<size_t> completed;
+    size_t first;
+    size_t submitted;
+    size_t inflight;
+    bool ready;
+    bool idle;
+};
+
+} // namespace detail
+
+FileBatch::FileBatch() : env(new detail::FileBatchEnv) {
+    env->grab();
+}
+
+FileBatch::~FileBatch() {
+    env->drop();
+}
+
+size_t FileBatch::read(int fd, const Buffer& buffer, int64_t offset) {
+    return env->queue(fd, buffer, offset, false);
+}
+
+size_t FileBatch::write(int fd, const Buffer& buffer, int64_t offset) {
+    return env->queue(fd, buffer, offset, true);
+}
+
+size_t FileBatch::read(int fd, const PooledBuffer& buffer, int64_t offset) {
+    size_t index = env->queue(fd, buffer.buffer(), offset, false);
+    env->operation(index).owner = buffer;
+    return index;
+}
+
+size_t FileBatch::write(int fd, const PooledBuffer& buffer, int64_t offset) {
+    size_t index = env->queue(fd, buffer.buffer(), offset, true);
+    env->operation(index).owner = buffer;
+    return index;
+}
+
+void FileBatch::submit() {
+    detail::IOContext& ioContext = env->scheduler->ioContext();
+#ifdef FIBERIZE_IO_URING
+    detail::Ring* ring = ioContext.ring();
+#endif
+
+    while (env->submitted < env->first + env->operations.size()) {
+        detail::FileOperation& operation = env->operation(env->submitted);
+        env->submitted += 1;
+
+        // Each operation in flight holds a reference.
+        env->grab();
+        env->inflight += 1;
+        env->idle = false;
+
+#ifdef FIBERIZE_IO_URING
+        if (ring != nullptr) {
+            operation.complete = detail::FileBatchEnv::ringCallback;
+            if (operation.write) {
+                ring->write(operation.fd, operation.buffer, operation.offset, &operation);
+            } else {
+                ring->read(operation.fd, operation.buffer, operation.offset, &operation);
+            }
+            continue;
+        }
+#endif
+
+        operation.request.data = &operation;
+        int code;
+        if (operation.write) {
+            code = uv_fs_write(ioContext.loop(), &operation.request, operation.fd, &operation.buffer, 1,
+                operation.offset, detail::FileBatchEnv::uvCallback);
+        } else {
+            code = uv_fs_read(ioContext.loop(), &operation.request, operation.fd, &operation.buffer, 1,
+                operation.offset, detail::FileBatchEnv::uvCallback);
+        }
+
+        // The operation could fail instantly.
+        if (code < 0) {
+            uv_fs_req_cleanup(&operation.request);
+            env->complete(&operation, code);
+        }
+    }
+
+#ifdef FIBERIZE_IO_URING
+    if (ring != nullptr)
+        ring->submit();
+#endif
+}
+
+size_t FileBatch::next() {
+    if (env->completed.empty()) {
+        if (env->inflight == 0)
+            return none;
+        context::processUntil(env->ready);
+    }
+
+    size_t index = env->completed.front();
+    env->completed.pop_front();
+    env->ready = !env->completed.empty();
+    return index;
+}
+
+void FileBatch::await(size_t index) {
+    detail::FileOperation& operation = env->operation(index);
+    assert(index < env->submitted);
+    context::processUntil(operation.done);
+    env->unqueue(index);
+}
+
+void FileBatch::awaitAll() {
+    context::processUntil(env->idle);
+}
+
+void FileBatch::release(size_t index) {
+    detail::FileOperation& operation = env->operation(index);
+    assert(operation.done);
+    operation.released = true;
+    env->unqueue(index);
+
+    while (!env->operations.empty() && env->operations.front().released) {
+        env->operations.pop_front();
+        env->first += 1;
+    }
+}
+
+size_t FileBatch::result(size_t index) const {
+    const detail::FileOperation& operation = env->operation(index);
+    assert(operation.done);
+    if (operation.result < 0)
+        throw std::system_error(int(-operation.result), std::system_category());
+    return size_t(operation.result);
+}
+
+size_t FileBatch::size() const {
+    return env->first + env->operations.size();
+}
+
+size_t FileBatch::pending() const {
+    return env->inflight;
+}
+
+} // namespace io
+} // namespace fiberize
@@ -0,0 +1,76 @@
+/**
+ * Sequential file reader with read-ahead.
+ *
+ * @file filereader.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/filereader.hpp>
+
+#include <algorithm>
+
+namespace fiberize {
+namespace io {
+
+constexpr size_t FileReader::defaultChunkSize;
+constexpr size_t FileReader::defaultDepth;
+
+FileReader::FileReader(int fd, int64_t offset, size_t chunkSize, size_t depth)
+    : fd(fd), offset_(offset), readOffset(offset)
+    , chunkSize(std::max<size_t>(chunkSize, 1)), depth(std::max<size_t>(depth, 1)), finished(false) {}
+
+PooledBuffer FileReader::read() {
+    readAhead();
+    if (chunks.empty())
+        return PooledBuffer();
+
+    Chunk chunk = std::move(chunks.front());
+    chunks.pop_front();
+    batch.await(chunk.index);
+
+    size_t length;
+    try {
+        length = batch.result(chunk.index);
+    } catch (...) {
+        batch.release(chunk.index);
+        finished = true;
+        throw;
+    }
+    batch.release(chunk.index);
+
+    // A short read means we reached the end of the file, the reads after it get nothing.
+    if (length < chunkSize)
+        finished = true;
+    if (length == 0)
+        return PooledBuffer();
+
+    chunk.buffer.resize(length);
+    offset_ += int64_t(length);
+    return std::move(chunk.buffer);
+}
+
+void FileReader::readAhead() {
+    if (finished) {
+        // Don't leave reads past the end in flight, they keep their buffers.
+        while (!chunks.empty()) {
+            batch.await(chunks.front().index);
+            batch.release(chunks.front().index);
+            chunks.pop_front();
+        }
+        return;
+    }
+
+    bool queued = false;
+    while (chunks.size() < depth) {
+        PooledBuffer buffer(chunkSize);
+        size_t index = batch.read(fd, buffer, readOffset);
+        chunks.push_back(Chunk{index, std::move(buffer)});
+        readOffset += int64_t(chunkSize);
+        queued = true;
+    }
+
+    if (queued)
+        batch.submit();
+}
+
+} // namespace io
+} // namespace fiberize
@@ -0,0 +1,93 @@
+/**
+ * Sequential file writer with write-behind.
+ *
+ * @file filewriter.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/filewriter.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace fiberize {
+namespace io {
+
+constexpr size_t FileWriter::defaultChunkSize;
+constexpr size_t FileWriter::defaultDepth;
+
+FileWriter::FileWriter(int fd, int64_t offset, size_t chunkSize, size_t depth)
+    : fd(fd), offset_(offset), chunkSize(std::max<size_t>(chunkSize, 1)), depth(std::max<size_t>(depth, 1)) {}
+
+void FileWriter::write(const char* data, size_t length) {
+    while (length > 0) {
+        if (!current) {
+            current = PooledBuffer(chunkSize);
+            current.resize(0);
+        }
+
+        size_t n = std::min(length, chunkSize - current.length());
+        std::memcpy(current.data() + current.length(), data, n);
+        current.resize(current.length() + n);
+        data += n;
+        length -= n;
+
+        if (current.length() == chunkSize) {
+            submit(current);
+            current = PooledBuffer();
+        }
+    }
+}
+
+void FileWriter::write(const PooledBuffer& buffer) {
+    if (current.length() > 0) {
+        submit(current);
+        current = PooledBuffer();
+    }
+
+    if (buffer.length() > 0)
+        submit(buffer);
+}
+
+void FileWriter::flush() {
+    if (current.length() > 0) {
+        submit(current);
+        current = PooledBuffer();
+    }
+
+    while (!inflight.empty())
+        retire();
+}
+
+void FileWriter::submit(const PooledBuffer& buffer) {
+    if (inflight.size() >= depth)
+        retire();
+
+    size_t index = batch.write(fd, buffer, offset_);
+    batch.submit();
+    inflight.push_back(Write{index, buffer.length()});
+    offset_ += int64_t(buffer.length());
+}
+
+void FileWriter::retire() {
+    Write write = inflight.front();
+    inflight.pop_front();
+    batch.await(write.index);
+
+    size_t written;
+    try {
+        written = batch.result(write.index);
+    } catch (...) {
+        batch.release(write.index);
+        throw;
+    }
+    batch.release(write.index);
+
+    // Regular files only write less when something went wrong, like running out of space.
+    if (written < write.length)
+        throw std::system_error(EIO, std::system_category());
+}
+
+} // namespace io
+} // namespace fiberize
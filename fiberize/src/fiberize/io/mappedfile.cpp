@@ -0,0 +1,255 @@
+/**
+ * Memory mapped files.
+ *
+ * @file mappedfile.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/mappedfile.hpp>
+#include <fiberize/io/detail/iocontext.hpp>
+#include <fiberize/io/detail/nonblocking.hpp>
+#include <fiberize/context.hpp>
+#include <fiberize/scheduler.hpp>
+#include <fiberize/scopedpin.hpp>
+#include <fiberize/event-inl.hpp>
+#include <fiberize/fiberref-inl.hpp>
+#include <fiberize/detail/task.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <limits>
+#include <mutex>
+#include <system_error>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fiberize {
+namespace io {
+namespace detail {
+
+Mapping::~Mapping() {
+    munmap(base, size);
+}
+
+namespace {
+
+uintptr_t pageSize() {
+    static const uintptr_t size = uintptr_t(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * Page aligned range containing the given memory. Mappings are page aligned, so it never leaves
+ * the mapping.
+ */
+struct PageRange {
+    PageRange(const char* data, size_t length) {
+        uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(pageSize() - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(data) + length;
+        start = reinterpret_cast<char*>(begin);
+        size = end - begin;
+    }
+
+    char* start;
+    size_t size;
+};
+
+int adviceFlag(Advice advice) {
+    switch (advice) {
+        case Advice::Sequential: return MADV_SEQUENTIAL;
+        case Advice::Random: return MADV_RANDOM;
+        default: return MADV_NORMAL;
+    }
+}
+
+/**
+ * Starts the readahead and reads one byte from every page, waiting for the faults.
+ */
+void touch(const char* data, size_t length) {
+    if (length == 0)
+        return;
+
+    PageRange range(data, length);
+    madvise(range.start, range.size, MADV_WILLNEED);
+
+    volatile char sink;
+    for (size_t offset = 0; offset < range.size; offset += pageSize())
+        sink = *static_cast<volatile const char*>(range.start + offset);
+    (void) sink;
+}
+
+/**
+ * Prefault request executed by the libuv threadpool. Holds a view, so the mapping stays alive
+ * until the work is done.
+ */
+struct PrefaultEnv : public fiberize::detail::ReferenceCountedAtomic {
+    PrefaultEnv(const MappedFile& file) : file(file), scheduler(context::scheduler()) {
+        request.data = this;
+    }
+
+    static void work(uv_work_t* req) {
+        auto env = reinterpret_cast<PrefaultEnv*>(req->data);
+        touch(env->file.data(), env->file.length());
+    }
+
+    uv_work_t request;
+    MappedFile file;
+    Scheduler* scheduler;
+};
+
+struct AwaitPrefaultEnv : public PrefaultEnv {
+    AwaitPrefaultEnv(const MappedFile& file) : PrefaultEnv(file), status(0), condition(false) {
+        task = context::detail::task();
+        task->grab();
+    }
+
+    virtual ~AwaitPrefaultEnv() {
+        task->drop();
+    }
+
+    static void callback(uv_work_t* req, int status) {
+        auto env = static_cast<AwaitPrefaultEnv*>(reinterpret_cast<PrefaultEnv*>(req->data));
+        env->scheduler->ioContext().recordCompletion();
+        env->status = status;
+
+        {
+            std::unique_lock<Spinlock> lock(env->task->spinlock);
+            env->condition = true;
+            context::detail::resume(env->task, std::move(lock));
+        }
+
+        env->drop();
+    }
+
+    fiberize::detail::Task* task;
+    int status;
+    bool condition;
+};
+
+struct AsyncPrefaultEnv : public PrefaultEnv {
+    AsyncPrefaultEnv(const MappedFile& file) : PrefaultEnv(file), self(context::self()) {}
+
+    static void callback(uv_work_t* req, int status) {
+        auto env = static_cast<AsyncPrefaultEnv*>(reinterpret_cast<PrefaultEnv*>(req->data));
+        env->scheduler->ioContext().recordCompletion();
+        Completion<void>::send(env->self, env->event, status);
+        env->drop();
+    }
+
+    FiberRef self;
+    Event<Result<void>> event;
+};
+
+IOResult<void, Block> prefault(Block, const MappedFile& file) {
+    touch(file.data(), file.length());
+}
+
+IOResult<void, Await> prefault(Await, const MappedFile& file) {
+    ScopedPin pin;
+    boost::intrusive_ptr<AwaitPrefaultEnv> env(new AwaitPrefaultEnv(file));
+
+    // Grab a reference for the callback.
+    env->grab();
+    int code = uv_queue_work(env->scheduler->ioContext().loop(), &env->request,
+        PrefaultEnv::work, AwaitPrefaultEnv::callback);
+    if (code < 0) {
+        env->drop();
+        throw std::system_error(-code, std::system_category());
+    }
+
+    context::processUntil(env->condition);
+    Completion<void>::value(env->status);
+}
+
+IOResult<void, Async> prefault(Async, const MappedFile& file) {
+    ScopedPin pin;
+    boost::intrusive_ptr<AsyncPrefaultEnv> env(new AsyncPrefaultEnv(file));
+
+    env->grab();
+    int code = uv_queue_work(env->scheduler->ioContext().loop(), &env->request,
+        PrefaultEnv::work, AsyncPrefaultEnv::callback);
+    if (code < 0) {
+        env->drop();
+        throw std::system_error(-code, std::system_category());
+    }
+
+    return env->event;
+}
+
+} // namespace
+
+} // namespace detail
+
+MappedFile::MappedFile(int fd, Advice advice) : MappedFile() {
+    struct stat info;
+    if (fstat(fd, &info) < 0)
+        throw std::system_error(errno, std::system_category());
+
+    *this = MappedFile(fd, 0, size_t(info.st_size), advice);
+}
+
+MappedFile::MappedFile(int fd, int64_t offset, size_t length, Advice advice) : MappedFile() {
+    if (offset < 0)
+        throw std::system_error(EINVAL, std::system_category());
+
+    // An empty region can't be mapped.
+    if (length == 0)
+        return;
+
+    // Touching a page past the end of the file raises SIGBUS, refuse such regions.
+    struct stat info;
+    if (fstat(fd, &info) < 0)
+        throw std::system_error(errno, std::system_category());
+    if (uint64_t(offset) > uint64_t(info.st_size) || length > uint64_t(info.st_size) - uint64_t(offset))
+        throw std::system_error(EINVAL, std::system_category());
+
+    // The offset passed to mmap must be page aligned.
+    size_t skip = size_t(uint64_t(offset) & (detail::pageSize() - 1));
+    size_t size = length + skip;
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, offset - int64_t(skip));
+    if (base == MAP_FAILED)
+        throw std::system_error(errno, std::system_category());
+
+    mapping = new detail::Mapping(base, size);
+    mapping->grab();
+    data_ = static_cast<const char*>(base) + skip;
+    length_ = length;
+    advise(advice);
+}
+
+Buffer MappedFile::buffer() const {
+    if (length_ > std::numeric_limits<uint>::max())
+        throw std::system_error(EOVERFLOW, std::system_category());
+    return Buffer(const_cast<char*>(data_), uint(length_));
+}
+
+MappedFile MappedFile::slice(size_t offset, size_t length) const {
+    assert(offset <= length_ && length <= length_ - offset);
+    MappedFile view(*this);
+    view.data_ = data_ + offset;
+    view.length_ = length;
+    return view;
+}
+
+void MappedFile::advise(Advice advice) const {
+    if (length_ == 0)
+        return;
+
+    detail::PageRange range(data_, length_);
+    madvise(range.start, range.size, detail::adviceFlag(advice));
+}
+
+template <typename Mode>
+IOResult<void, Mode> MappedFile::prefault() const {
+    return detail::prefault(Mode(), *this);
+}
+
+template IOResult<void, Block> MappedFile::prefault<Block>() const;
+template IOResult<void, Await> MappedFile::prefault<Await>() const;
+template IOResult<void, Async> MappedFile::prefault<Async>() const;
+
+} // namespace io
+} // namespace fiberize
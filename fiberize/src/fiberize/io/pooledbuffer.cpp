@@ -0,0 +1,23 @@
+/**
+ * Reference counted buffers allocated from the scheduler's pool.
+ *
+ * @file pooledbuffer.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/pooledbuffer.hpp>
+#include <fiberize/scheduler.hpp>
+
+namespace fiberize {
+namespace io {
+
+PooledBuffer::PooledBuffer(size_t length) : length_(length) {
+    Scheduler* scheduler = Scheduler::current();
+    if (scheduler != nullptr) {
+        block = scheduler->ioContext().bufferPool().allocate(length);
+    } else {
+        block = detail::BufferPool::allocateUnpooled(length);
+    }
+}
+
+} // namespace io
+} // namespace fiberize
@@ -1,10 +1,11 @@
 #include <fiberize/io/sleep.hpp>
 #include <fiberize/scheduler.hpp>
 #include <fiberize/context.hpp>
-#include <fiberize/io/detail/libuvwrapper.hpp>
-#include <fiberize/scopedpin.hpp>
+#include <fiberize/fiberref-inl.hpp>
+#include <fiberize/detail/timerwheel.hpp>
+#include <fiberize/detail/refrencecounted.hpp>
 
-#include <uv.h>
+#include <boost/intrusive_ptr.hpp>
 
 namespace fiberize {
 namespace io {
@@ -14,77 +15,96 @@ void millisleep<Block>(const std::chrono::milliseconds& duration) {
     std::this_thread::sleep_for(duration);
 }
 
-template <>
-void millisleep<Await>(const std::chrono::milliseconds& duration) {
-    using Env = detail::AwaitHandleEnv<uv_timer_t>;
-    uv_loop_t* loop = Scheduler::current()->ioContext().loop();
-    ScopedPin pin;
+namespace {
 
-    /**
-     * Create the environment for the request. The environment cannot be located on the stack, because
-     * some event handler could throw an exception before the callback is complete.
-     */
-    boost::intrusive_ptr<Env> env(new Env);
+/**
+ * Returns the deadline of a sleep starting now. Rounded up, so that we sleep at least the
+ * given duration.
+ */
+uint64_t deadlineAfter(const std::chrono::milliseconds& duration) {
+    uint64_t delay = duration.count() > 0 ? uint64_t(duration.count()) : 0;
+    return fiberize::detail::TimerWheel::now() + delay + 1;
+}
 
-    /**
-     * Initialize the timer.
-     */
-    int code = uv_timer_init(loop, &env->handle);
-    if (code < 0) {
-        throw std::system_error(-code, std::system_category());
+/**
+ * Timer of a fiber sleeping in Await mode.
+ *
+ * The timer is owned by the scheduler that started the sleep and expires on its thread, but the
+ * fiber itself is not pinned and can be resumed anywhere. The timer cannot be located on the
+ * stack, because some event handler could throw an exception before it expires.
+ */
+struct AwaitTimer : public fiberize::detail::Timer, public fiberize::detail::ReferenceCountedAtomic {
+    AwaitTimer() {
+        expired = callback;
+        condition = false;
+        task = context::detail::task();
+        task->grab();
     }
 
-    /**
-     * Grab a reference for the callback and start the timer.
-     */
-    env->grab();
-    code = uv_timer_start(&env->handle, Env::callback, duration.count(), std::numeric_limits<uint64_t>::max());
-    if (code < 0) {
-        env->drop();
-        throw std::system_error(-code, std::system_category());
+    virtual ~AwaitTimer() {
+        task->drop();
     }
 
-    /**
-     * Wait until the callback fires.
-     */
-    context::processUntil(env->condition);
-}
+    static void callback(fiberize::detail::Timer* timer) {
+        auto self = static_cast<AwaitTimer*>(timer);
 
-static void noResult(uv_timer_t*) {}
+        /**
+         * Set the condition to true and reschedule the fiber, if necesssary.
+         */
+        std::unique_lock<Spinlock> lock(self->task->spinlock);
+        self->condition = true;
+        context::detail::resume(self->task, std::move(lock));
 
-template <>
-Event<Result<void>> millisleep<Async>(const std::chrono::milliseconds& duration) {
-    using Env = detail::AsyncHandleEnv<void, uv_timer_t, noResult>;
-    uv_loop_t* loop = Scheduler::current()->ioContext().loop();
-    ScopedPin pin;
+        self->drop();
+    }
 
-    /**
-     * Create the environment.
-     */
-    boost::intrusive_ptr<Env> env(new Env);
+    bool condition;
+    fiberize::detail::Task* task;
+};
 
-    /**
-     * Initialize the timer.
-     */
-    int code = uv_timer_init(loop, &env->handle);
-    if (code < 0) {
-        throw std::system_error(-code, std::system_category());
+/**
+ * Timer firing an event in Async mode.
+ */
+struct AsyncTimer : public fiberize::detail::Timer {
+    AsyncTimer() {
+        expired = callback;
+        self = context::self();
     }
 
+    static void callback(fiberize::detail::Timer* timer) {
+        auto env = static_cast<AsyncTimer*>(timer);
+        env->self.send(env->event);
+        delete env;
+    }
+
+    Event<Result<void>> event;
+    FiberRef self;
+};
+
+} // namespace
+
+template <>
+void millisleep<Await>(const std::chrono::milliseconds& duration) {
+    boost::intrusive_ptr<AwaitTimer> timer(new AwaitTimer);
+
     /**
      * Grab a reference for the callback and start the timer.
      */
-    env->grab();
-    code = uv_timer_start(&env->handle, Env::callback, duration.count(), std::numeric_limits<uint64_t>::max());
-    if (code < 0) {
-        env->drop();
-        throw std::system_error(-code, std::system_category());
-    }
+    timer->grab();
+    Scheduler::current()->timers().schedule(timer.get(), deadlineAfter(duration));
 
     /**
-     * Returns the event.
+     * Wait until the timer expires.
      */
-    return env->event;
+    context::processUntil(timer->condition);
+}
+
+template <>
+Event<Result<void>> millisleep<Async>(const std::chrono::milliseconds& duration) {
+    AsyncTimer* timer = new AsyncTimer;
+    Event<Result<void>> event = timer->event;
+    Scheduler::current()->timers().schedule(timer, deadlineAfter(duration));
+    return event;
 }
 
 } // namespace io
@@ -0,0 +1,212 @@
+/**
+ * TCP sockets.
+ *
+ * @file tcp.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/tcp.hpp>
+#include <fiberize/io/endpoint.hpp>
+#include <fiberize/io/detail/nonblocking.hpp>
+
+#include <cerrno>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fiberize {
+namespace io {
+namespace tcp {
+
+namespace {
+
+/**
+ * Disables Nagle's algorithm, fibers write whole messages.
+ */
+void noDelay(int socket) {
+    int one = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+struct Listen {
+    ssize_t operator () () {
+        Endpoint endpoint;
+        try {
+            endpoint = Endpoint(address, port);
+        } catch (const std::system_error& error) {
+            return -error.code().value();
+        }
+
+        fd = socket(endpoint.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return detail::lastError();
+
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, endpoint.data(), endpoint.size()) < 0
+            || ::listen(fd, backlog) < 0) {
+            ssize_t result = detail::lastError();
+            ::close(fd);
+            return result;
+        }
+
+        return fd;
+    }
+
+    const char* address;
+    uint16_t port;
+    int backlog;
+    int fd;
+    int events;
+};
+
+struct Accept {
+    ssize_t operator () () {
+        int socket = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0)
+            return detail::lastError();
+
+        noDelay(socket);
+        return socket;
+    }
+
+    int fd;
+    int events;
+};
+
+struct Connect {
+    ssize_t operator () () {
+        // The connection is in progress, check how it ended.
+        if (fd >= 0) {
+            int code = 0;
+            socklen_t length = sizeof(code);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &code, &length) < 0)
+                code = errno;
+            return finish(code);
+        }
+
+        Endpoint endpoint;
+        try {
+            endpoint = Endpoint(address, port);
+        } catch (const std::system_error& error) {
+            return -error.code().value();
+        }
+
+        fd = socket(endpoint.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return detail::lastError();
+
+        noDelay(fd);
+        if (::connect(fd, endpoint.data(), endpoint.size()) < 0)
+            return finish(errno);
+        return fd;
+    }
+
+    ssize_t finish(int code) {
+        if (code == 0)
+            return fd;
+        if (code == EINPROGRESS)
+            return -EAGAIN;
+
+        ::close(fd);
+        fd = -1;
+        return -code;
+    }
+
+    const char* address;
+    uint16_t port;
+    int fd;
+    int events;
+};
+
+struct Read {
+    ssize_t operator () () {
+        ssize_t n = recv(fd, buffer.data(), buffer.length(), 0);
+        return n < 0 ? detail::lastError() : n;
+    }
+
+    Buffer buffer;
+    int fd;
+    int events;
+};
+
+struct Write {
+    ssize_t operator () () {
+        while (written < buffer.length()) {
+            ssize_t n = send(fd, buffer.data() + written, buffer.length() - written, MSG_NOSIGNAL);
+            if (n < 0)
+                return detail::lastError();
+            written += size_t(n);
+        }
+        return ssize_t(written);
+    }
+
+    Buffer buffer;
+    size_t written;
+    int fd;
+    int events;
+};
+
+struct Shutdown {
+    ssize_t operator () () {
+        return ::shutdown(fd, SHUT_WR) < 0 ? detail::lastError() : 0;
+    }
+
+    int fd;
+    int events;
+};
+
+} // namespace
+
+template <typename Mode>
+IOResult<int, Mode> listen(const char* address, uint16_t port, int backlog) {
+    return detail::runNonblocking<int, Mode>(Listen{address, port, backlog, -1, 0});
+}
+
+template <typename Mode>
+IOResult<int, Mode> accept(int listener) {
+    return detail::runNonblocking<int, Mode>(Accept{listener, UV_READABLE});
+}
+
+template <typename Mode>
+IOResult<int, Mode> connect(const char* address, uint16_t port) {
+    // The address is only used by the first attempt, which happens before we return.
+    return detail::runNonblocking<int, Mode>(Connect{address, port, -1, UV_WRITABLE});
+}
+
+template <typename Mode>
+IOResult<size_t, Mode> read(int socket, const Buffer& buffer) {
+    return detail::runNonblocking<size_t, Mode>(Read{buffer, socket, UV_READABLE});
+}
+
+template <typename Mode>
+IOResult<size_t, Mode> write(int socket, const Buffer& buffer) {
+    return detail::runNonblocking<size_t, Mode>(Write{buffer, 0, socket, UV_WRITABLE});
+}
+
+template <typename Mode>
+IOResult<void, Mode> shutdown(int socket) {
+    return detail::runNonblocking<void, Mode>(Shutdown{socket, 0});
+}
+
+uint16_t localPort(int socket) {
+    return Endpoint::local(socket).port();
+}
+
+#define FIBERIZE_IO_TCP_INSTANTIATE(Mode) \
+    template IOResult<int, Mode> listen<Mode>(const char*, uint16_t, int); \
+    template IOResult<int, Mode> accept<Mode>(int); \
+    template IOResult<int, Mode> connect<Mode>(const char*, uint16_t); \
+    template IOResult<size_t, Mode> read<Mode>(int, const Buffer&); \
+    template IOResult<size_t, Mode> write<Mode>(int, const Buffer&); \
+    template IOResult<void, Mode> shutdown<Mode>(int);
+
+FIBERIZE_IO_TCP_INSTANTIATE(Block)
+FIBERIZE_IO_TCP_INSTANTIATE(Await)
+FIBERIZE_IO_TCP_INSTANTIATE(Async)
+
+} // namespace tcp
+} // namespace io
+} // namespace fiberize
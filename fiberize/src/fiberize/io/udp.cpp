@@ -0,0 +1,232 @@
+/**
+ * UDP sockets.
+ *
+ * @file udp.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/io/udp.hpp>
+#include <fiberize/io/detail/nonblocking.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fiberize {
+namespace io {
+namespace udp {
+
+namespace {
+
+// On Unix libuv defines uv_buf_t with the layout of iovec, so buffers are passed to the kernel directly.
+static_assert(sizeof(Buffer) == sizeof(iovec), "Buffer must have the layout of iovec");
+
+iovec* iov(const Buffer* bufs) {
+    return reinterpret_cast<iovec*>(const_cast<Buffer*>(bufs));
+}
+
+/**
+ * Number of message headers prepared on the stack for a single sendmmsg or recvmmsg call.
+ */
+constexpr uint batchSize = 64;
+
+struct Bind {
+    ssize_t operator () () {
+        Endpoint endpoint;
+        try {
+            endpoint = Endpoint(address, port);
+        } catch (const std::system_error& error) {
+            return -error.code().value();
+        }
+
+        fd = socket(endpoint.family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return detail::lastError();
+
+        if (::bind(fd, endpoint.data(), endpoint.size()) < 0) {
+            ssize_t result = detail::lastError();
+            ::close(fd);
+            return result;
+        }
+
+        return fd;
+    }
+
+    const char* address;
+    uint16_t port;
+    int fd;
+    int events;
+};
+
+struct SendTo {
+    ssize_t operator () () {
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_name = const_cast<sockaddr*>(to.data());
+        message.msg_namelen = to.size();
+        message.msg_iov = iov(bufs);
+        message.msg_iovlen = nbufs;
+
+        ssize_t n = sendmsg(fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        return n < 0 ? detail::lastError() : n;
+    }
+
+    const Buffer* bufs;
+    uint nbufs;
+    Endpoint to;
+    int fd;
+    int events;
+};
+
+struct RecvFrom {
+    ssize_t operator () () {
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        if (from != nullptr) {
+            message.msg_name = from->data();
+            message.msg_namelen = Endpoint::capacity();
+        }
+        message.msg_iov = iov(bufs);
+        message.msg_iovlen = nbufs;
+
+        ssize_t n = recvmsg(fd, &message, MSG_DONTWAIT);
+        if (n < 0)
+            return detail::lastError();
+
+        if (from != nullptr)
+            from->resize(message.msg_namelen);
+        return n;
+    }
+
+    const Buffer* bufs;
+    uint nbufs;
+    Endpoint* from;
+    int fd;
+    int events;
+};
+
+/**
+ * Fills a message header for a datagram.
+ */
+void prepare(mmsghdr& header, Datagram& datagram, socklen_t namelen) {
+    std::memset(&header, 0, sizeof(header));
+    header.msg_hdr.msg_name = datagram.peer.data();
+    header.msg_hdr.msg_namelen = namelen;
+    header.msg_hdr.msg_iov = iov(datagram.bufs);
+    header.msg_hdr.msg_iovlen = datagram.nbufs;
+}
+
+struct SendMany {
+    ssize_t operator () () {
+        mmsghdr headers[batchSize];
+        while (sent < n) {
+            uint count = std::min(n - sent, batchSize);
+            for (uint i = 0; i < count; ++i)
+                prepare(headers[i], datagrams[sent + i], datagrams[sent + i].peer.size());
+
+            int result = ::sendmmsg(fd, headers, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (result < 0) {
+                // Wait for space if the buffer is full. Otherwise report what was sent, the error
+                // will show up again on the next call.
+                ssize_t error = detail::lastError();
+                if (sent > 0 && error != -EAGAIN)
+                    break;
+                return error;
+            }
+
+            for (int i = 0; i < result; ++i)
+                datagrams[sent + i].length = headers[i].msg_len;
+            sent += uint(result);
+        }
+        return sent;
+    }
+
+    Datagram* datagrams;
+    uint n;
+    uint sent;
+    int fd;
+    int events;
+};
+
+struct RecvMany {
+    ssize_t operator () () {
+        mmsghdr headers[batchSize];
+        uint received = 0;
+        while (received < n) {
+            uint count = std::min(n - received, batchSize);
+            for (uint i = 0; i < count; ++i)
+                prepare(headers[i], datagrams[received + i], Endpoint::capacity());
+
+            int result = ::recvmmsg(fd, headers, count, MSG_DONTWAIT, nullptr);
+            if (result < 0) {
+                // Return what we have, the error will show up again on the next call.
+                if (received > 0)
+                    break;
+                return detail::lastError();
+            }
+
+            for (int i = 0; i < result; ++i) {
+                Datagram& datagram = datagrams[received + i];
+                datagram.length = headers[i].msg_len;
+                datagram.peer.resize(headers[i].msg_hdr.msg_namelen);
+            }
+            received += uint(result);
+
+            // The socket was drained.
+            if (uint(result) < count)
+                break;
+        }
+        return received;
+    }
+
+    Datagram* datagrams;
+    uint n;
+    int fd;
+    int events;
+};
+
+} // namespace
+
+template <typename Mode>
+IOResult<int, Mode> bind(const char* address, uint16_t port) {
+    return detail::runNonblocking<int, Mode>(Bind{address, port, -1, 0});
+}
+
+template <typename Mode>
+IOResult<size_t, Mode> sendto(int socket, const Buffer bufs[], uint nbufs, const Endpoint& to) {
+    return detail::runNonblocking<size_t, Mode>(SendTo{bufs, nbufs, to, socket, UV_WRITABLE});
+}
+
+template <typename Mode>
+IOResult<size_t, Mode> recvfrom(int socket, const Buffer bufs[], uint nbufs, Endpoint* from) {
+    return detail::runNonblocking<size_t, Mode>(RecvFrom{bufs, nbufs, from, socket, UV_READABLE});
+}
+
+template <typename Mode>
+IOResult<uint, Mode> sendmmsg(int socket, Datagram datagrams[], uint n) {
+    return detail::runNonblocking<uint, Mode>(SendMany{datagrams, n, 0, socket, UV_WRITABLE});
+}
+
+template <typename Mode>
+IOResult<uint, Mode> recvmmsg(int socket, Datagram datagrams[], uint n) {
+    return detail::runNonblocking<uint, Mode>(RecvMany{datagrams, n, socket, UV_READABLE});
+}
+
+#define FIBERIZE_IO_UDP_INSTANTIATE(Mode) \
+    template IOResult<int, Mode> bind<Mode>(const char*, uint16_t); \
+    template IOResult<size_t, Mode> sendto<Mode>(int, const Buffer[], uint, const Endpoint&); \
+    template IOResult<size_t, Mode> recvfrom<Mode>(int, const Buffer[], uint, Endpoint*); \
+    template IOResult<uint, Mode> sendmmsg<Mode>(int, Datagram[], uint); \
+    template IOResult<uint, Mode> recvmmsg<Mode>(int, Datagram[], uint);
+
+FIBERIZE_IO_UDP_INSTANTIATE(Block)
+FIBERIZE_IO_UDP_INSTANTIATE(Await)
+FIBERIZE_IO_UDP_INSTANTIATE(Async)
+
+} // namespace udp
+} // namespace io
+} // namespace fiberize
@@ -1,23 +1,44 @@
 #include <fiberize/mailbox.hpp>
+#include <fiberize/scheduler.hpp>
+#include <fiberize/exceptions.hpp>
+
+#include <algorithm>
+#include <thread>
 
 namespace fiberize {
 
 Mailbox::~Mailbox() {
 }
 
+void Mailbox::dequeued() {
+}
+
+size_t Mailbox::dequeueBatch(PendingEvent* events, size_t n) {
+    size_t i = 0;
+    while (i < n && dequeue(events[i]))
+        i += 1;
+    return i;
+}
+
+bool Mailbox::concurrentEnqueue() const {
+    return false;
+}
+
 DequeMailbox::~DequeMailbox() {
     clear();
 }
 
-void DequeMailbox::enqueue(const PendingEvent& event) {
-    pendingEvents.push_back(event);
+bool DequeMailbox::enqueue(PendingEvent&& event) {
+    bool wasEmpty = pendingEvents.empty();
+    pendingEvents.push_back(std::move(event));
+    return wasEmpty;
 }
 
 bool DequeMailbox::dequeue(PendingEvent& event) {
     if (pendingEvents.empty()) {
         return false;
     } else {
-        event = pendingEvents.front();
+        event = std::move(pendingEvents.front());
         pendingEvents.pop_front();
         return true;
     }
@@ -28,10 +49,255 @@ bool DequeMailbox::empty() {
 }
 
 void DequeMailbox::clear() {
-    for (auto& event : pendingEvents) {
-        if (event.freeData)
-            event.freeData(event.data);
+    pendingEvents.clear();
+}
+
+/**
+ * Nodes freed by the consumer are kept in a small thread local cache, so that fibers sending
+ * to each other on the same thread don't hit the allocator.
+ */
+constexpr size_t nodeCacheSize = 256;
+
+struct NodeCache {
+    std::vector<void*> nodes;
+
+    ~NodeCache() {
+        for (void* node : nodes)
+            ::operator delete(node);
+    }
+};
+
+static thread_local NodeCache nodeCache;
+
+void* MPSCMailbox::Node::operator new(size_t size) {
+    auto& nodes = nodeCache.nodes;
+    if (nodes.empty())
+        return ::operator new(size);
+
+    void* node = nodes.back();
+    nodes.pop_back();
+    return node;
+}
+
+void MPSCMailbox::Node::operator delete(void* node) {
+    auto& nodes = nodeCache.nodes;
+    if (nodes.size() < nodeCacheSize) {
+        nodes.push_back(node);
+    } else {
+        ::operator delete(node);
+    }
+}
+
+MPSCMailbox::MPSCMailbox()
+    : count(0) {
+    tail = new Node;
+    tail->next.store(nullptr, std::memory_order_relaxed);
+    head.store(tail, std::memory_order_relaxed);
+}
+
+MPSCMailbox::MPSCMailbox(const MPSCMailbox&)
+    : MPSCMailbox() {
+}
+
+MPSCMailbox::MPSCMailbox(MPSCMailbox&& other)
+    : MPSCMailbox() {
+    PendingEvent event;
+    while (other.dequeue(event))
+        enqueue(std::move(event));
+}
+
+MPSCMailbox::~MPSCMailbox() {
+    clear();
+    delete tail;
+}
+
+bool MPSCMailbox::enqueue(PendingEvent&& event) {
+    Node* node = new Node;
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->event = std::move(event);
+
+    Node* prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+    return count.fetch_add(1, std::memory_order_acq_rel) == 0;
+}
+
+bool MPSCMailbox::dequeue(PendingEvent& event) {
+    if (count.load(std::memory_order_acquire) == 0)
+        return false;
+
+    // The count was incremented, but the node could be not linked yet.
+    Node* next;
+    while ((next = tail->next.load(std::memory_order_acquire)) == nullptr) {
+        // Spin.
+    }
+
+    event = std::move(next->event);
+    delete tail;
+    tail = next;
+    count.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+size_t MPSCMailbox::dequeueBatch(PendingEvent* events, size_t n) {
+    n = std::min(n, count.load(std::memory_order_acquire));
+    for (size_t i = 0; i < n; ++i) {
+        Node* next;
+        while ((next = tail->next.load(std::memory_order_acquire)) == nullptr) {
+            // Spin.
+        }
+
+        events[i] = std::move(next->event);
+        delete tail;
+        tail = next;
+    }
+
+    // Decrement once for the whole batch, senders see a non-empty mailbox until we are done.
+    if (n > 0)
+        count.fetch_sub(n, std::memory_order_release);
+    return n;
+}
+
+bool MPSCMailbox::concurrentEnqueue() const {
+    return true;
+}
+
+bool MPSCMailbox::empty() {
+    return count.load(std::memory_order_acquire) == 0;
+}
+
+void MPSCMailbox::clear() {
+    PendingEvent event;
+    while (dequeue(event)) {
+        // The event is destroyed by the next dequeue.
     }
 }
 
+BoundedMailbox::BoundedMailbox(size_t capacity, OverflowPolicy policy)
+    : capacity_(capacity)
+    , policy(policy)
+    , pendingEvents(capacity)
+    , waiting(0)
+    , closed(false)
+    , sendersToWake(0) {
+    assert(capacity > 0);
+}
+
+BoundedMailbox::BoundedMailbox(const BoundedMailbox& other)
+    : BoundedMailbox(other.capacity_, other.policy) {
+}
+
+BoundedMailbox::BoundedMailbox(BoundedMailbox&& other)
+    : BoundedMailbox(other.capacity_, other.policy) {
+    std::swap(pendingEvents, other.pendingEvents);
+}
+
+BoundedMailbox::~BoundedMailbox() {
+    clear();
+}
+
+bool BoundedMailbox::enqueue(PendingEvent&& event) {
+    std::unique_lock<Spinlock> lock(spinlock);
+
+    while (pendingEvents.full() && !closed) {
+        // Fibers always wait, other threads only when asked to.
+        Scheduler* scheduler = Scheduler::current();
+        bool suspendable = scheduler != nullptr
+            && (scheduler->isMultiTasking() || policy == OverflowPolicy::Block);
+
+        if (suspendable) {
+            waiting += 1;
+            try {
+                notFull.await(lock);
+            } catch (...) {
+                waiting -= 1;
+                throw;
+            }
+            waiting -= 1;
+            continue;
+        }
+
+        switch (policy) {
+            case OverflowPolicy::Block:
+                // A foreign thread, we have no way to suspend it.
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+                break;
+
+            case OverflowPolicy::DropNewest:
+                return false;
+
+            case OverflowPolicy::DropOldest:
+                pendingEvents.pop_front();
+                break;
+
+            case OverflowPolicy::Fail:
+                throw MailboxFull();
+        }
+    }
+
+    // The receiver is dead, nobody will ever read this event.
+    if (closed)
+        return false;
+
+    bool wasEmpty = pendingEvents.empty();
+    pendingEvents.push_back(std::move(event));
+    return wasEmpty;
+}
+
+bool BoundedMailbox::dequeue(PendingEvent& event) {
+    std::unique_lock<Spinlock> lock(spinlock);
+    if (pendingEvents.empty())
+        return false;
+
+    event = std::move(pendingEvents.front());
+    pendingEvents.pop_front();
+
+    // Senders can be woken up only without the task lock, see dequeued().
+    if (waiting > sendersToWake)
+        sendersToWake += 1;
+    return true;
+}
+
+size_t BoundedMailbox::dequeueBatch(PendingEvent* events, size_t n) {
+    std::unique_lock<Spinlock> lock(spinlock);
+    n = std::min(n, pendingEvents.size());
+    for (size_t i = 0; i < n; ++i) {
+        events[i] = std::move(pendingEvents.front());
+        pendingEvents.pop_front();
+    }
+
+    sendersToWake = std::min(waiting, sendersToWake + n);
+    return n;
+}
+
+void BoundedMailbox::dequeued() {
+    if (sendersToWake == 0)
+        return;
+
+    std::unique_lock<Spinlock> lock(spinlock);
+    for (; sendersToWake > 0; --sendersToWake)
+        notFull.signal(lock);
+}
+
+bool BoundedMailbox::concurrentEnqueue() const {
+    return true;
+}
+
+bool BoundedMailbox::empty() {
+    std::unique_lock<Spinlock> lock(spinlock);
+    return pendingEvents.empty();
+}
+
+void BoundedMailbox::clear() {
+    std::unique_lock<Spinlock> lock(spinlock);
+    closed = true;
+
+    // Destroy the events after releasing the lock.
+    boost::circular_buffer<PendingEvent> events;
+    std::swap(events, pendingEvents);
+    notFull.signalAll(lock);
+    lock.unlock();
+}
+
 } // namespace fiberize
@@ -0,0 +1,31 @@
+/**
+ * Offloading blocking calls.
+ *
+ * @file offload.cpp
+ * @copyright 2015 Paweł Nowak
+ */
+#include <fiberize/offload.hpp>
+#include <fiberize/fibersystem.hpp>
+#include <fiberize/scopedpin.hpp>
+
+namespace fiberize {
+namespace context {
+namespace detail {
+
+void offload(fiberize::detail::OffloadJob* job) {
+    /**
+     * The worker resumes the fiber without a scheduler, it must know where to send it. The worker
+     * sets done while we are still running, processUntil checks it again under the task lock
+     * before suspending, so that wakeup isn't lost.
+     */
+    ScopedPin pin;
+
+    job->task = task();
+    job->task->grab();
+    system()->offloadPool().submit(job);
+    processUntil(job->done);
+}
+
+} // namespace detail
+} // namespace context
+} // namespace fiberize
@@ -5,15 +5,28 @@
  * @copyright 2015 Paweł Nowak
  */
 #include <fiberize/scheduler.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <thread>
-#include <chrono>
+#include <system_error>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 namespace fiberize {
 
 Scheduler::Scheduler(FiberSystem* system, uint64_t seed)
-    : system_(system), random_(seed) {}
+    : system_(system), parked_(false), random_(seed) {
+    wakeupFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd_ < 0)
+        throw std::system_error(errno, std::system_category());
+}
 
-Scheduler::~Scheduler() {}
+Scheduler::~Scheduler() {
+    close(wakeupFd_);
+}
 
 void Scheduler::makeCurrent() {
     current_ = this;
@@ -24,43 +37,102 @@ void Scheduler::resetCurrent() {
 }
 
 void Scheduler::idle(uint64_t& idleStreak) {
-    using namespace std::literals;
-
     if (idleStreak <= 16) {
         // Nothing.
     } else if (idleStreak <= 64) {
         // Yield.
         std::this_thread::yield();
-    } else if (idleStreak <= 64 * 1024) {
-        // Nanosleep.
-        std::this_thread::sleep_for(1ns);
     } else {
-        // Millisleep.
-        std::this_thread::sleep_for(1ms);
+        // Park until there is something to do, then spin again.
+        park();
+        idleStreak = 0;
+        return;
     }
 
     idleStreak += 1;
 }
 
-void Scheduler::kill(detail::Task* task, std::unique_lock<Spinlock>&& lock) {
-    if (task->refCount == 0) {
-        lock.release();
-        delete task;
-    } else {
-        task->status = detail::Dead;
-        task->scheduled = false;
-        task->refCount += 1;
-        lock.unlock();
-        task->runnable.reset();
-        task->mailbox->clear();
-        task->handlers.clear();
-        lock.lock();
-        task->refCount -= 1;
-        if (task->refCount == 0) {
-            lock.release();
-            delete task;
-        }
+void Scheduler::park() {
+    uv_loop_t* loop = ioContext().loop();
+
+    // Run the loop once, this also registers new watchers in the backend.
+    if (ioContext().poll())
+        return;
+
+    // Timers could have expired while we were looking for work.
+    if (expireTimers())
+        return;
+
+    /**
+     * Announce that we are going to sleep and check for work again. Whoever submits work after
+     * this point will see the flag and wake us up.
+     */
+    parked_.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!canPark()) {
+        parked_.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    int timeout = -1;
+    if (uv_loop_alive(loop)) {
+        uv_update_time(loop);
+        timeout = uv_backend_timeout(loop);
+    }
+
+    // Wake up for the next timer, rounding up so that we don't wake up just before it.
+    uint64_t next = timers_.nextExpiration();
+    if (next != detail::TimerWheel::never) {
+        uint64_t now = detail::TimerWheel::now();
+        uint64_t wait = next > now ? std::min<uint64_t>(next - now + 1, INT_MAX) : 0;
+        if (timeout < 0 || wait < uint64_t(timeout))
+            timeout = int(wait);
     }
+
+    pollfd fds[2];
+    fds[0].fd = wakeupFd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = uv_backend_fd(loop);
+    fds[1].events = POLLIN;
+    int ready = ::poll(fds, 2, timeout);
+
+    parked_.store(false, std::memory_order_relaxed);
+
+    // Consume the wakeup, if any. A late unpark can leave a spurious one, which is harmless.
+    uint64_t value;
+    while (read(wakeupFd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+        // Retry.
+    }
+
+    // Process IO events and expired timers.
+    if (ready == 0 || (ready > 0 && fds[1].revents != 0))
+        ioContext().poll();
+    expireTimers();
+}
+
+bool Scheduler::unpark() {
+    if (!parked_.load(std::memory_order_seq_cst))
+        return false;
+    if (!parked_.exchange(false, std::memory_order_seq_cst))
+        return false;
+
+    uint64_t value = 1;
+    while (write(wakeupFd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+        // Retry.
+    }
+    return true;
+}
+
+void Scheduler::kill(detail::Task* task, std::unique_lock<Spinlock>&& lock) {
+    task->status = detail::Dead;
+    task->scheduled = false;
+    lock.unlock();
+
+    // Free the resources now, the memory goes away with the last reference.
+    task->runnable.reset();
+    task->mailbox->clear();
+    task->handlers.clear();
+    task->drop();
 }
 
 thread_local Scheduler* Scheduler::current_ = nullptr;
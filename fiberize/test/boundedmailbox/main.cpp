@@ -0,0 +1,88 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+using namespace fiberize;
+
+const uint messages = 100000;
+const size_t capacity = 4;
+
+Event<uint> number;
+
+TEST(BoundedMailbox, ShouldSuspendSenders) {
+    FiberSystem system;
+    system.fiberize();
+
+    auto receiver = system.future([] () {
+        for (uint i = 0; i < messages; ++i) {
+            EXPECT_EQ(i, number.await());
+        }
+    }, BoundedMailbox(capacity)).run();
+
+    auto sender = system.future([] (FutureRef<void> receiver) {
+        for (uint i = 0; i < messages; ++i) {
+            receiver.send(number, i);
+        }
+    }).run(receiver);
+
+    sender.await();
+    receiver.await();
+}
+
+/**
+ * The receiver doesn't process events until we let it go.
+ */
+std::atomic<bool> go;
+
+std::vector<uint> receiveAll() {
+    while (!go.load())
+        std::this_thread::yield();
+
+    std::vector<uint> received;
+    for (size_t i = 0; i < capacity; ++i) {
+        received.push_back(number.await());
+    }
+    return received;
+}
+
+TEST(BoundedMailbox, ShouldFailWhenFull) {
+    FiberSystem system;
+    system.fiberize();
+    go = false;
+
+    auto receiver = system.future(receiveAll, BoundedMailbox(capacity, OverflowPolicy::Fail)).run();
+    for (uint i = 0; i < capacity; ++i) {
+        receiver.send(number, i);
+    }
+    EXPECT_THROW(receiver.send(number, capacity), MailboxFull);
+
+    go = true;
+    EXPECT_EQ(std::vector<uint>({0, 1, 2, 3}), receiver.await().get());
+}
+
+TEST(BoundedMailbox, ShouldDropOldest) {
+    FiberSystem system;
+    system.fiberize();
+    go = false;
+
+    auto receiver = system.future(receiveAll, BoundedMailbox(capacity, OverflowPolicy::DropOldest)).run();
+    for (uint i = 0; i < 10; ++i) {
+        receiver.send(number, i);
+    }
+
+    go = true;
+    EXPECT_EQ(std::vector<uint>({6, 7, 8, 9}), receiver.await().get());
+}
+
+TEST(BoundedMailbox, ShouldDropNewest) {
+    FiberSystem system;
+    system.fiberize();
+    go = false;
+
+    auto receiver = system.future(receiveAll, BoundedMailbox(capacity, OverflowPolicy::DropNewest)).run();
+    for (uint i = 0; i < 10; ++i) {
+        receiver.send(number, i);
+    }
+
+    go = true;
+    EXPECT_EQ(std::vector<uint>({0, 1, 2, 3}), receiver.await().get());
+}
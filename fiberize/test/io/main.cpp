@@ -1,6 +1,13 @@
 #include <fiberize/fiberize.hpp>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
 using namespace fiberize;
 
 std::string fileTest(std::string data, std::string path) {
@@ -39,6 +46,291 @@ TEST(File, FiberReadsAndWrites) {
     }
 }
 
+std::string pooledFileTest(std::string data, std::string path) {
+    io::PooledBuffer in(data.size());
+    std::copy(data.begin(), data.end(), in.data());
+    io::PooledBuffer out(data.size());
+
+    int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+    io::write(file, in, 0);
+    out.resize(io::read(file, out, 0));
+    io::close(file);
+
+    return std::string(out.data(), out.length());
+}
+
+TEST(PooledBuffer, ReadsAndWrites) {
+    EXPECT_EQ(data, pooledFileTest(data, path));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(data, fiberSystem.future(pooledFileTest).run(data, path).await().get());
+    }
+}
+
+TEST(PooledBuffer, Aligned) {
+    for (size_t size : {0, 1, 100, 4096, 100000, 1000000}) {
+        io::PooledBuffer buffer(size);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(buffer.data()) % 64);
+        EXPECT_LE(size, buffer.capacity());
+        EXPECT_EQ(size, buffer.length());
+    }
+}
+
+TEST(PooledBuffer, Reused) {
+    char* data = fiberSystem.future([] () {
+        char* first = io::PooledBuffer(1000).data();
+        // The buffer was released, the pool gives it back.
+        return first == io::PooledBuffer(1000).data() ? first : nullptr;
+    }).run().await().get();
+    EXPECT_NE(nullptr, data);
+}
+
+TEST(PooledBuffer, SentWithoutCopying) {
+    Event<io::PooledBuffer> chunk;
+    Event<void> done;
+
+    auto consumer = fiberSystem.future([chunk, done] () {
+        io::PooledBuffer received = chunk.await();
+        std::string text(received.data(), received.length());
+        done.await();
+        return std::make_pair(received.data(), text);
+    }).run();
+
+    // Released in the consumer, on whichever scheduler it runs.
+    auto producer = fiberSystem.future([consumer, chunk] () {
+        io::PooledBuffer buffer(64);
+        std::string text = "log line";
+        std::copy(text.begin(), text.end(), buffer.data());
+        buffer.resize(text.size());
+        consumer.send(chunk, buffer);
+        return buffer.data();
+    }).run();
+
+    char* sent = producer.await().get();
+    consumer.send(done);
+    auto received = consumer.await().get();
+    EXPECT_EQ(sent, received.first);
+    EXPECT_EQ("log line", received.second);
+}
+
+TEST(PooledBuffer, ManyReleasedElsewhere) {
+    // Buffers allocated by one fiber and released by many others must all go back to the pool.
+    std::set<char*> blocks;
+    for (int round = 0; round < 20; ++round) {
+        std::vector<FutureRef<void>> refs;
+        for (int i = 0; i < 100; ++i) {
+            io::PooledBuffer buffer(512);
+            blocks.insert(buffer.data());
+            refs.push_back(fiberSystem.future([buffer] () {
+                io::PooledBuffer copy = buffer;
+                copy.data()[0] = 'x';
+            }).run());
+        }
+        for (auto& ref : refs) {
+            ref.await();
+        }
+    }
+
+    // 2000 allocations, but a 256 KiB slab holds a few hundred of these. Without reuse every
+    // allocation would get a new block.
+    EXPECT_LT(blocks.size(), 1000u);
+}
+
+TEST(FileBatch, WritesAndReads) {
+    static const size_t blocks = 64;
+    static const size_t blockSize = 512;
+
+    fiberSystem.future([] () {
+        int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+
+        std::vector<char> out(blocks * blockSize);
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = char(i / blockSize);
+        }
+
+        io::FileBatch writes;
+        for (size_t i = 0; i < blocks; ++i) {
+            writes.write(file, io::Buffer(&out[i * blockSize], blockSize), i * blockSize);
+        }
+        writes.submit();
+        writes.awaitAll();
+        EXPECT_EQ(0u, writes.pending());
+        for (size_t i = 0; i < blocks; ++i) {
+            EXPECT_EQ(blockSize, writes.result(i));
+        }
+
+        // Read the blocks back in reverse, streaming the completions.
+        std::vector<char> in(blocks * blockSize);
+        io::FileBatch reads;
+        for (size_t i = 0; i < blocks; ++i) {
+            reads.read(file, io::Buffer(&in[i * blockSize], blockSize), (blocks - 1 - i) * blockSize);
+        }
+        reads.submit();
+
+        std::vector<bool> seen(blocks, false);
+        size_t index;
+        size_t count = 0;
+        while ((index = reads.next()) != io::FileBatch::none) {
+            EXPECT_FALSE(seen[index]);
+            seen[index] = true;
+            count += 1;
+            EXPECT_EQ(blockSize, reads.result(index));
+            EXPECT_EQ(char(blocks - 1 - index), in[index * blockSize]);
+        }
+        EXPECT_EQ(blocks, count);
+
+        io::close(file);
+    }).run().await().get();
+}
+
+TEST(FileBatch, Errors) {
+    fiberSystem.future([] () {
+        char data[16];
+        io::FileBatch batch;
+        EXPECT_EQ(io::FileBatch::none, batch.next());
+
+        size_t index = batch.read(-1, io::Buffer(data, sizeof(data)), 0);
+        batch.submit();
+        EXPECT_EQ(index, batch.next());
+        EXPECT_THROW(batch.result(index), std::system_error);
+        EXPECT_EQ(io::FileBatch::none, batch.next());
+    }).run().await().get();
+}
+
+TEST(FileStream, WritesAndReads) {
+    fiberSystem.future([] () {
+        int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+
+        // Appends of different sizes, crossing the chunk boundaries.
+        std::string expected;
+        io::FileWriter writer(file, 0, 4096, 3);
+        for (size_t i = 0; expected.size() < 100000; ++i) {
+            std::string record(i % 1000, char('a' + i % 26));
+            writer.write(record.data(), record.size());
+            expected += record;
+        }
+
+        // A pooled buffer is written as it is.
+        io::PooledBuffer tail(5000);
+        std::fill(tail.data(), tail.data() + tail.length(), 'z');
+        writer.write(tail);
+        expected.append(5000, 'z');
+
+        writer.flush();
+        EXPECT_EQ(int64_t(expected.size()), writer.offset());
+
+        std::string actual;
+        io::FileReader reader(file, 0, 3000, 5);
+        for (const io::PooledBuffer& chunk : reader) {
+            EXPECT_LE(chunk.length(), 3000u);
+            actual.append(chunk.data(), chunk.length());
+        }
+        EXPECT_EQ(expected, actual);
+        EXPECT_EQ(int64_t(expected.size()), reader.offset());
+        EXPECT_FALSE(reader.read());
+
+        // Start in the middle.
+        io::FileReader middle(file, 99000, 4096, 2);
+        io::PooledBuffer chunk = middle.read();
+        EXPECT_EQ(expected.substr(99000, 4096), std::string(chunk.data(), chunk.length()));
+
+        io::close(file);
+    }).run().await().get();
+}
+
+TEST(FileStream, ReadError) {
+    fiberSystem.future([] () {
+        io::FileReader reader(-1);
+        EXPECT_THROW(reader.read(), std::system_error);
+    }).run().await().get();
+}
+
+TEST(MappedFile, ReadsAndSlices) {
+    fiberSystem.future([] () {
+        std::string expected;
+        for (size_t i = 0; expected.size() < 100000; ++i)
+            expected += std::to_string(i) + '\n';
+
+        int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+        io::Buffer buffer(&expected[0], uint(expected.size()));
+        io::write(file, &buffer, 1, 0);
+
+        io::MappedFile whole(file);
+        whole.prefault();
+        EXPECT_EQ(expected, std::string(whole.data(), whole.length()));
+
+        // The offset doesn't have to be page aligned.
+        io::MappedFile region(file, 5000, 20000, io::Advice::Random);
+        region.prefault<io::Block>();
+        EXPECT_EQ(expected.substr(5000, 20000), std::string(region.data(), region.length()));
+
+        io::MappedFile slice = region.slice(100, 1000);
+        slice.prefault<io::Async>().await().get();
+        EXPECT_EQ(expected.substr(5100, 1000), std::string(slice.data(), slice.length()));
+
+        io::close(file);
+    }).run().await().get();
+}
+
+TEST(MappedFile, SentWithoutCopying) {
+    Event<io::MappedFile> chunk;
+
+    auto consumer = fiberSystem.future([chunk] () {
+        io::MappedFile received = chunk.await();
+        received.prefault();
+        return std::make_pair(received.data(), std::string(received.data(), received.length()));
+    }).run();
+
+    // The consumer keeps the mapping alive after the producer drops its views.
+    auto producer = fiberSystem.future([consumer, chunk] () {
+        std::string text = "mapped log line";
+        io::Buffer buffer(&text[0], uint(text.size()));
+        int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+        io::write(file, &buffer, 1, 0);
+        io::MappedFile mapped(file);
+        io::close(file);
+
+        io::MappedFile slice = mapped.slice(7, 3);
+        consumer.send(chunk, slice);
+        return slice.data();
+    }).run();
+
+    const char* sent = producer.await().get();
+    auto received = consumer.await().get();
+    EXPECT_EQ(sent, received.first);
+    EXPECT_EQ("log", received.second);
+}
+
+TEST(MappedFile, RejectsRegionsPastTheEnd) {
+    std::string text = "short file";
+    io::Buffer buffer(&text[0], uint(text.size()));
+    int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+    io::write(file, &buffer, 1, 0);
+
+    EXPECT_EQ(text, std::string(io::MappedFile(file, 0, text.size()).data(), text.size()));
+    EXPECT_THROW(io::MappedFile(file, 0, text.size() + 1), std::system_error);
+    EXPECT_THROW(io::MappedFile(file, 4096, 1), std::system_error);
+    io::close(file);
+}
+
+TEST(MappedFile, LargeViewsNeedSlicing) {
+    // A sparse file, none of it is touched.
+    int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+    ASSERT_EQ(0, ftruncate(file, off_t(5) << 30));
+
+    io::MappedFile mapped(file);
+    EXPECT_THROW(mapped.buffer(), std::system_error);
+    EXPECT_EQ(4096u, mapped.slice(size_t(4) << 30, 4096).buffer().length());
+    io::close(file);
+}
+
+TEST(MappedFile, Empty) {
+    int file = io::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0777);
+    io::MappedFile mapped(file);
+    EXPECT_FALSE(mapped);
+    EXPECT_EQ(0u, mapped.length());
+    io::close(file);
+}
+
 int main(int argc, char **argv) {
     fiberSystem.fiberize();
     ::testing::InitGoogleTest(&argc, argv);
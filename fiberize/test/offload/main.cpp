@@ -0,0 +1,105 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace fiberize;
+using namespace std::literals;
+
+TEST(Offload, ReturnsValues) {
+    FiberSystem system;
+    system.fiberize();
+
+    auto ref = system.future([] () {
+        std::thread::id fiberThread = std::this_thread::get_id();
+        Result<std::thread::id> worker = context::offload([] () {
+            return std::this_thread::get_id();
+        });
+        EXPECT_NE(fiberThread, worker.get());
+
+        Result<int> value = context::offload([] () { return 42; });
+        EXPECT_EQ(42, value.get());
+
+        Result<void> nothing = context::offload([] () {});
+        EXPECT_TRUE(nothing.isValue());
+    }).run();
+    ref.await().get();
+}
+
+TEST(Offload, ReturnsExceptions) {
+    FiberSystem system;
+    system.fiberize();
+
+    Result<int> result = context::offload([] () -> int {
+        throw std::runtime_error("blocking call failed");
+    });
+    EXPECT_TRUE(result.isException());
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(Offload, RunsConcurrently) {
+    FiberSystem system(2);
+    system.fiberize();
+    system.offloadThreads(32);
+
+    // Every call waits until all of them started, which only works if they run at the same time.
+    std::mutex mutex;
+    std::condition_variable arrived;
+    size_t started = 0;
+    std::vector<FutureRef<bool>> refs;
+    for (int i = 0; i < 32; ++i) {
+        refs.push_back(system.future([&] () {
+            return context::offload([&] () {
+                std::unique_lock<std::mutex> lock(mutex);
+                started += 1;
+                arrived.notify_all();
+                return arrived.wait_for(lock, 10s, [&] () { return started == 32; });
+            }).get();
+        }).run());
+    }
+    for (auto& ref : refs) {
+        EXPECT_TRUE(ref.await().get());
+    }
+
+    OffloadStats stats = system.offloadStats();
+    EXPECT_LE(stats.threads, 32u);
+    EXPECT_EQ(0u, stats.running);
+    EXPECT_EQ(0u, stats.queued);
+    EXPECT_EQ(32u, stats.completed);
+}
+
+TEST(Offload, ShrinksWhenIdle) {
+    FiberSystem system;
+    system.fiberize();
+    system.offloadIdleTimeout(50ms);
+
+    context::offload([] () {}).get();
+    EXPECT_EQ(1u, system.offloadStats().completed);
+
+    std::this_thread::sleep_for(500ms);
+    EXPECT_EQ(0u, system.offloadStats().threads);
+}
+
+TEST(Offload, RespectsTheLimit) {
+    FiberSystem system;
+    system.fiberize();
+    system.offloadThreads(2);
+
+    std::vector<FutureRef<void>> refs;
+    for (int i = 0; i < 8; ++i) {
+        refs.push_back(system.future([] () {
+            context::offload([] () { std::this_thread::sleep_for(20ms); }).get();
+        }).run());
+    }
+    for (auto& ref : refs) {
+        ref.await();
+    }
+
+    EXPECT_LE(system.offloadStats().threads, 2u);
+    EXPECT_EQ(8u, system.offloadStats().completed);
+}
@@ -0,0 +1,92 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace fiberize;
+using namespace std::literals;
+
+/**
+ * Waits until the pool has the given number of parked threads.
+ */
+void waitForIdle(FiberSystem& system, size_t idle) {
+    for (int i = 0; i < 1000 && system.osThreadPool().idle() != idle; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(idle, system.osThreadPool().idle());
+}
+
+TEST(OSThread, ReusesThreads) {
+    FiberSystem system;
+    system.fiberize();
+
+    std::set<std::thread::id> threads;
+    for (int i = 0; i < 10; ++i) {
+        auto ref = system.future([] () {
+            // The task can receive events on its thread.
+            Event<int> event;
+            context::self().send(event, 7);
+            EXPECT_EQ(7, event.await());
+            return std::this_thread::get_id();
+        }).osthread().run();
+        threads.insert(ref.await().get());
+        waitForIdle(system, 1);
+    }
+
+    EXPECT_EQ(1u, threads.size());
+    EXPECT_EQ(0u, threads.count(std::this_thread::get_id()));
+}
+
+TEST(OSThread, ReceivesEventsSentBeforeStart) {
+    FiberSystem system;
+    system.fiberize();
+
+    Event<int> event;
+    for (int i = 0; i < 100; ++i) {
+        auto ref = system.future([event] () {
+            std::thread::id thread = std::this_thread::get_id();
+            int value = event.await();
+            EXPECT_EQ(thread, std::this_thread::get_id());
+            return value;
+        }).osthread().run();
+
+        // The task is still queued in the pool, it must not be resumed anywhere else.
+        ref.send(event, i);
+        EXPECT_EQ(i, ref.await().get());
+    }
+}
+
+TEST(OSThread, RunsConcurrently) {
+    FiberSystem system;
+    system.fiberize();
+    system.osThreadIdleLimit(4);
+
+    std::vector<FutureRef<std::thread::id>> refs;
+    for (int i = 0; i < 16; ++i) {
+        refs.push_back(system.future([] () {
+            std::this_thread::sleep_for(100ms);
+            return std::this_thread::get_id();
+        }).osthread().run());
+    }
+
+    std::set<std::thread::id> threads;
+    for (auto& ref : refs) {
+        threads.insert(ref.await().get());
+    }
+    EXPECT_EQ(16u, threads.size());
+
+    // Only the limit is kept.
+    waitForIdle(system, 4);
+}
+
+TEST(OSThread, ExitsWhenIdle) {
+    FiberSystem system;
+    system.fiberize();
+    system.osThreadIdleTimeout(50ms);
+
+    system.future([] () {}).osthread().run().await();
+    waitForIdle(system, 0);
+}
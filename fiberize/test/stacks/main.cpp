@@ -0,0 +1,172 @@
+#include <fiberize/fiberize.hpp>
+#include <fiberize/detail/guardedstack.hpp>
+#include <fiberize/detail/stackpool.hpp>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace fiberize;
+
+const size_t fibers = 10000;
+
+Event<void> go;
+Event<void> done;
+
+/**
+ * Suspends, so that the fiber keeps its stack until it gets the go event.
+ */
+void waiter(FiberRef parent) {
+    go.await();
+    parent.send(done);
+}
+
+TEST(Stacks, ShouldRunFibersWithDifferentStackSizes) {
+    FiberSystem system;
+    FiberRef self = system.fiberize();
+    system.stackPoolWatermarks(4, 16);
+
+    const size_t sizes[] = { 0, 16 * 1024, 64 * 1024, 256 * 1024 };
+    std::vector<FiberRef> refs;
+    for (size_t i = 0; i < fibers; ++i) {
+        refs.push_back(system.fiber(waiter).stackSize(sizes[i % 4]).run(self));
+    }
+
+    for (FiberRef& ref : refs) {
+        ref.send(go);
+    }
+
+    for (size_t i = 0; i < fibers; ++i) {
+        done.await();
+    }
+}
+
+TEST(Stacks, ShouldUseTheRequestedStackSize) {
+    FiberSystem system;
+    system.fiberize();
+
+    auto future = system.future([] () {
+        // Use most of a 1MB stack.
+        volatile char buffer[768 * 1024];
+        buffer[0] = 1;
+        buffer[sizeof(buffer) - 1] = 1;
+        return buffer[0] + buffer[sizeof(buffer) - 1];
+    }).stackSize(1024 * 1024).run();
+
+    EXPECT_EQ(2, future.await().get());
+}
+
+const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+
+/**
+ * Returns the number of resident pages in a page aligned range.
+ */
+size_t residentPages(uintptr_t start, uintptr_t end) {
+    std::vector<unsigned char> pages((end - start) / pageSize);
+    if (mincore(reinterpret_cast<void*>(start), end - start, pages.data()) != 0)
+        return 0;
+    return size_t(std::count_if(pages.begin(), pages.end(), [] (unsigned char page) { return page & 1; }));
+}
+
+TEST(GuardedStack, OverflowHitsTheGuardPage) {
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+    detail::GuardedStackAllocator allocator(64 * 1024);
+    boost::context::stack_context stack = allocator.allocate();
+    volatile char* bottom = static_cast<char*>(stack.sp) - stack.size;
+
+    // The whole stack is usable, one byte more faults.
+    bottom[0] = 1;
+    EXPECT_DEATH(bottom[-1] = 1, "");
+
+    allocator.deallocate(stack);
+}
+
+TEST(GuardedStack, ReleasesPagesBelowTheStackPointer) {
+    detail::GuardedStackAllocator allocator(256 * 1024);
+    boost::context::stack_context stack = allocator.allocate();
+    uintptr_t top = reinterpret_cast<uintptr_t>(stack.sp);
+    uintptr_t bottom = top - stack.size;
+
+    // Pretend that the stack pointer is 16 KiB from the top. The page with it and the one below
+    // it are kept, everything below goes.
+    uintptr_t sp = top - 16 * 1024 + 8;
+    uintptr_t kept = (sp & ~(pageSize - 1)) - pageSize;
+
+    for (bool lazy : {false, true}) {
+        std::memset(reinterpret_cast<void*>(bottom), 1, stack.size);
+        detail::GuardedStackAllocator::release(stack, reinterpret_cast<void*>(sp), lazy);
+
+        // Pages freed lazily stay resident until the kernel needs them.
+        if (!lazy) {
+            EXPECT_EQ(0u, residentPages(bottom, kept));
+        }
+        EXPECT_EQ((top - kept) / pageSize, residentPages(kept, top));
+
+        // The released pages can be used again.
+        std::memset(reinterpret_cast<void*>(bottom), 2, stack.size);
+        const char* memory = reinterpret_cast<const char*>(bottom);
+        EXPECT_TRUE(std::all_of(memory, memory + stack.size, [] (char c) { return c == 2; }));
+    }
+
+    allocator.deallocate(stack);
+}
+
+#ifdef FIBERIZE_GUARDED_STACKS
+
+const size_t deepFrame = 64 * 1024;
+boost::context::fcontext_t poolTestCaller;
+
+/**
+ * Fills a large frame and checks it, leaving garbage below the stack pointer of the caller.
+ */
+__attribute__((noinline)) bool useStack() {
+    volatile char frame[deepFrame];
+    for (size_t i = 0; i < deepFrame; i += 64)
+        frame[i] = char(i / 64);
+
+    bool ok = true;
+    for (size_t i = 0; i < deepFrame; i += 64)
+        ok = ok && frame[i] == char(i / 64);
+    return ok;
+}
+
+void useStackForever(intptr_t argument) {
+    auto context = reinterpret_cast<detail::PooledContext*>(argument);
+    for (;;) {
+        bool ok = useStack();
+        boost::context::jump_fcontext(&context->context, poolTestCaller, ok);
+    }
+}
+
+TEST(StackPool, ReleasesPooledStacks) {
+    detail::GlobalStackPool global;
+    global.lowWatermark.store(0);
+    global.lazyRelease.store(false);
+    detail::StackPool pool(&global, useStackForever);
+
+    size_t sizeClass = detail::StackClasses::classOf(256 * 1024);
+    detail::PooledContext* context = pool.get(sizeClass);
+    EXPECT_TRUE(intptr_t(boost::context::jump_fcontext(&poolTestCaller, context->context, intptr_t(context))));
+
+    // The saved context is the lowest live part of the stack, the frame below it is garbage.
+    pool.put(context);
+    uintptr_t top = reinterpret_cast<uintptr_t>(context->stack.sp);
+    uintptr_t bottom = top - context->stack.size;
+    uintptr_t saved = reinterpret_cast<uintptr_t>(context->context);
+    uintptr_t kept = (saved & ~(pageSize - 1)) - pageSize;
+    ASSERT_GT(kept, bottom + deepFrame / 2);
+    EXPECT_EQ(0u, residentPages(bottom, kept));
+
+    // The same stack comes back and still works.
+    EXPECT_EQ(context, pool.get(sizeClass));
+    EXPECT_TRUE(intptr_t(boost::context::jump_fcontext(&poolTestCaller, context->context, intptr_t(context))));
+    pool.put(context);
+}
+
+#endif // FIBERIZE_GUARDED_STACKS
@@ -0,0 +1,109 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace fiberize;
+
+FiberSystem fiberSystem;
+
+/**
+ * Echoes everything until the client shuts down its side.
+ */
+void echo(int socket) {
+    char data[4096];
+    while (size_t n = io::tcp::read(socket, io::Buffer(data, sizeof(data)))) {
+        io::tcp::write(socket, io::Buffer(data, n));
+    }
+    io::close(socket);
+}
+
+/**
+ * Accepts the given number of connections and serves each one in a new fiber.
+ */
+void server(int listener, int connections) {
+    for (int i = 0; i < connections; ++i) {
+        int socket = io::tcp::accept(listener);
+        fiberSystem.fiber(echo).run(socket);
+    }
+    io::close(listener);
+}
+
+template <typename Mode>
+std::string roundTrip(uint16_t port, std::string message) {
+    int socket = io::tcp::connect<io::Await>("127.0.0.1", port);
+
+    // Write from another fiber, the echo comes back before we finish writing a long message.
+    auto writer = fiberSystem.future([socket, message] () mutable {
+        io::tcp::write(socket, io::Buffer(&message[0], message.size()));
+        io::tcp::shutdown(socket);
+    }).run();
+
+    std::string received;
+    char buffer[1024];
+    for (;;) {
+        size_t n;
+        if (std::is_same<Mode, io::Async>{}) {
+            n = io::tcp::read<io::Async>(socket, io::Buffer(buffer, sizeof(buffer))).await().get();
+        } else if (std::is_same<Mode, io::Block>{}) {
+            n = io::tcp::read<io::Block>(socket, io::Buffer(buffer, sizeof(buffer)));
+        } else {
+            n = io::tcp::read<io::Await>(socket, io::Buffer(buffer, sizeof(buffer)));
+        }
+
+        if (n == 0)
+            break;
+        received.append(buffer, n);
+    }
+
+    writer.await();
+    io::close(socket);
+    return received;
+}
+
+TEST(Tcp, EchoFromThread) {
+    int listener = io::tcp::listen("127.0.0.1", 0);
+    uint16_t port = io::tcp::localPort(listener);
+    fiberSystem.fiber(server).run(listener, 3);
+
+    EXPECT_EQ("Hello world!", roundTrip<io::Await>(port, "Hello world!"));
+    EXPECT_EQ("Hello world!", roundTrip<io::Block>(port, "Hello world!"));
+    EXPECT_EQ("Hello world!", roundTrip<io::Async>(port, "Hello world!"));
+}
+
+TEST(Tcp, ManyFibers) {
+    const int clients = 100;
+
+    int listener = io::tcp::listen("127.0.0.1", 0);
+    uint16_t port = io::tcp::localPort(listener);
+    fiberSystem.fiber(server).run(listener, clients);
+
+    // A message larger than the socket buffers, so that both sides have to wait.
+    std::string message(1 << 20, 'x');
+    for (size_t i = 0; i < message.size(); i += 7) {
+        message[i] = char('a' + i % 26);
+    }
+
+    std::vector<FutureRef<std::string>> refs;
+    for (int i = 0; i < clients; ++i) {
+        refs.push_back(fiberSystem.future(roundTrip<io::Await>).run(port, i % 10 == 0 ? message : "ping"));
+    }
+
+    for (int i = 0; i < clients; ++i) {
+        EXPECT_EQ(i % 10 == 0 ? message : "ping", refs[i].await().get());
+    }
+}
+
+TEST(Tcp, ConnectionRefused) {
+    int listener = io::tcp::listen("127.0.0.1", 0);
+    uint16_t port = io::tcp::localPort(listener);
+    io::close(listener);
+
+    EXPECT_THROW(io::tcp::connect("127.0.0.1", port), std::system_error);
+}
+
+int main(int argc, char **argv) {
+    fiberSystem.fiberize();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace fiberize;
+using namespace std::literals;
+
+Event<void> tick;
+
+/**
+ * An actor that keeps its own mailbox busy forever.
+ */
+struct Spinner {
+    HandlerRef handleTick;
+
+    void operator () () {
+        FiberRef self = context::self();
+        handleTick = tick.bind([self] () {
+            self.send(tick);
+        });
+
+        for (int i = 0; i < 4; ++i) {
+            self.send(tick);
+        }
+    }
+};
+
+TEST(Throughput, BusyActorShouldNotStarveOthers) {
+    FiberSystem system(1);
+    system.fiberize();
+
+    auto spinner = system.actor(Spinner{}).throughput(8).run();
+    auto future = system.future([] () {
+        return 42;
+    }).run();
+
+    EXPECT_EQ(42, future.await().get());
+    spinner.kill();
+}
+
+/**
+ * A spinner that counts the events it handled.
+ */
+struct CountingSpinner {
+    std::atomic<uint64_t>* counter;
+    HandlerRef handleTick;
+
+    void operator () () {
+        FiberRef self = context::self();
+        std::atomic<uint64_t>* counter = this->counter;
+        handleTick = tick.bind([self, counter] () {
+            counter->fetch_add(1, std::memory_order_relaxed);
+            self.send(tick);
+        });
+
+        for (int i = 0; i < 4; ++i) {
+            self.send(tick);
+        }
+    }
+};
+
+TEST(Throughput, BusyActorsShouldInterleave) {
+    FiberSystem system(1);
+    system.fiberize();
+
+    std::atomic<uint64_t> first(0);
+    std::atomic<uint64_t> second(0);
+    auto a = system.actor(CountingSpinner{&first, {}}).throughput(8).run();
+    auto b = system.actor(CountingSpinner{&second, {}}).throughput(8).run();
+
+    // Both actors stay runnable on the same scheduler, each must get its turn.
+    std::this_thread::sleep_for(200ms);
+    uint64_t firstBefore = first.load();
+    uint64_t secondBefore = second.load();
+    std::this_thread::sleep_for(200ms);
+
+    EXPECT_GT(first.load(), firstBefore);
+    EXPECT_GT(second.load(), secondBefore);
+
+    a.kill();
+    b.kill();
+}
+
+TEST(Throughput, IdleSchedulersTakeRequeuedActors) {
+    FiberSystem system(2);
+    system.fiberize();
+
+    // The spinner starts next to a fiber that then hogs its scheduler. The other scheduler has to
+    // take the spinner over after it gets requeued.
+    std::atomic<uint64_t> counter(0);
+    auto hog = system.future([&] () {
+        auto spinner = system.actor(CountingSpinner{&counter, {}}).throughput(8).run();
+        for (int i = 0; i < 8; ++i) {
+            context::yield();
+        }
+
+        uint64_t before = counter.load();
+        auto end = std::chrono::steady_clock::now() + 300ms;
+        while (std::chrono::steady_clock::now() < end) {
+            // Busy, without yielding.
+        }
+        uint64_t after = counter.load();
+
+        spinner.kill();
+        return after > before;
+    }).run();
+
+    EXPECT_TRUE(hog.await().get());
+}
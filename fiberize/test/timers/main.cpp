@@ -1,6 +1,7 @@
 #include <fiberize/fiberize.hpp>
 #include <gtest/gtest.h>
 #include <chrono>
+#include <thread>
 
 using namespace fiberize;
 using namespace std::literals;
@@ -31,3 +32,188 @@ TEST(Sleep, ShouldWork) {
 
     refs.clear();
 }
+
+TEST(Sleep, ManyShortSleepsAcrossSchedulers) {
+    FiberSystem fiberSystem(4);
+    fiberSystem.fiberize();
+
+    // The fibers migrate between the sleeps, so timers often expire while they run elsewhere.
+    std::vector<FutureRef<void>> refs;
+    auto sleeper = fiberSystem.future([] () {
+        for (int i = 0; i < 50; ++i) {
+            io::sleep(1ms);
+            context::yield();
+        }
+    });
+
+    for (size_t i = 0; i < 200; ++i) {
+        refs.push_back(sleeper.copy().run());
+    }
+
+    for (FutureRef<void>& ref : refs) {
+        ref.await();
+    }
+}
+
+TEST(TimerWheel, ExpiresInOrder) {
+    detail::TimerWheel wheel;
+    uint64_t start = detail::TimerWheel::now();
+
+    static std::vector<uint64_t> expired;
+    expired.clear();
+
+    // Deadlines spread over several levels of the wheel.
+    std::vector<uint64_t> delays = {0, 1, 63, 64, 65, 4095, 4096, 300000, 20000000};
+    std::vector<detail::Timer> timers(delays.size());
+    for (size_t i = 0; i < delays.size(); ++i) {
+        timers[i].expired = [] (detail::Timer* timer) { expired.push_back(timer->deadline); };
+        wheel.schedule(&timers[i], start + delays[i]);
+    }
+
+    // Cancel one of them.
+    wheel.cancel(&timers[3]);
+    delays.erase(delays.begin() + 3);
+
+    for (size_t i = 0; i < delays.size(); ++i) {
+        uint64_t deadline = start + delays[i];
+        EXPECT_LE(wheel.nextExpiration(), deadline);
+
+        // Nothing expires early.
+        wheel.advance(deadline - 1);
+        EXPECT_EQ(i, expired.size());
+
+        wheel.advance(deadline);
+        ASSERT_EQ(i + 1, expired.size());
+        EXPECT_EQ(deadline, expired.back());
+    }
+
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(detail::TimerWheel::never, wheel.nextExpiration());
+}
+
+TEST(TimerWheel, CancelsFromAnotherThread) {
+    detail::TimerWheel wheel;
+    uint64_t start = detail::TimerWheel::now();
+
+    static std::vector<std::pair<detail::Timer*, bool>> withdrawn;
+    static size_t expired;
+    withdrawn.clear();
+    expired = 0;
+
+    std::vector<detail::Timer> timers(2);
+    for (detail::Timer& timer : timers) {
+        timer.expired = [] (detail::Timer*) { expired += 1; };
+        timer.withdrawn = [] (detail::Timer* timer, bool removed) {
+            withdrawn.emplace_back(timer, removed);
+        };
+    }
+    wheel.schedule(&timers[0], start + 3600000);
+    wheel.schedule(&timers[1], start);
+
+    // The second timer expires before the owner sees the request.
+    wheel.advance(start);
+    EXPECT_EQ(1u, expired);
+
+    std::thread([&] () {
+        wheel.cancelConcurrent(&timers[0]);
+        wheel.cancelConcurrent(&timers[1]);
+    }).join();
+
+    // Nothing happens until the owner collects the requests.
+    EXPECT_TRUE(withdrawn.empty());
+    EXPECT_FALSE(wheel.empty());
+
+    wheel.collectCancelled();
+    ASSERT_EQ(2u, withdrawn.size());
+    for (auto& request : withdrawn)
+        EXPECT_EQ(request.first == &timers[0], request.second);
+
+    EXPECT_TRUE(wheel.empty());
+    wheel.advance(start + 3600000);
+    EXPECT_EQ(1u, expired);
+}
+
+TEST(Timeout, EventAwaitFor) {
+    FiberSystem fiberSystem;
+    FiberRef self = fiberSystem.fiberize();
+
+    Event<int> value;
+    Event<void> signal;
+
+    // Nothing arrives.
+    EXPECT_FALSE(value.awaitFor(50ms));
+    EXPECT_FALSE(signal.awaitFor(50ms));
+
+    // The events arrive before the deadline.
+    self.send(value, 42);
+    self.send(signal);
+    EXPECT_EQ(42, value.awaitFor(1s).value_or(0));
+    EXPECT_TRUE(signal.awaitFor(1s));
+}
+
+TEST(Timeout, FutureAwaitFor) {
+    FiberSystem fiberSystem;
+    fiberSystem.fiberize();
+
+    auto slow = fiberSystem.future([] () {
+        io::sleep(300ms);
+        return 7;
+    }).run();
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(slow.awaitFor(50ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+
+    auto result = slow.awaitFor(5s);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(7, result->get());
+}
+
+TEST(Timeout, FibersAwaitFor) {
+    FiberSystem fiberSystem;
+    fiberSystem.fiberize();
+
+    // Many fibers timing out at once, each cancelling its timer on the way out.
+    std::vector<FutureRef<bool>> refs;
+    auto waiter = fiberSystem.future([] () {
+        Event<void> never;
+        bool timedOut = !never.awaitFor(100ms);
+        context::self().send(never);
+        bool signaled = never.awaitFor(1s);
+        return timedOut && signaled;
+    });
+
+    for (size_t i = 0; i < 1000; ++i) {
+        refs.push_back(waiter.copy().run());
+    }
+
+    for (FutureRef<bool>& ref : refs) {
+        EXPECT_TRUE(ref.await().get());
+    }
+}
+
+TEST(Timeout, FibersTimeOutAcrossSchedulers) {
+    FiberSystem fiberSystem(4);
+    fiberSystem.fiberize();
+
+    // Timeouts expire on the scheduler that started them, often while the fiber runs elsewhere.
+    std::vector<FutureRef<size_t>> refs;
+    auto waiter = fiberSystem.future([] () {
+        Event<void> never;
+        size_t timedOut = 0;
+        for (int i = 0; i < 50; ++i) {
+            if (!never.awaitFor(1ms))
+                timedOut += 1;
+            context::yield();
+        }
+        return timedOut;
+    });
+
+    for (size_t i = 0; i < 200; ++i) {
+        refs.push_back(waiter.copy().run());
+    }
+
+    for (FutureRef<size_t>& ref : refs) {
+        EXPECT_EQ(50u, ref.await().get());
+    }
+}
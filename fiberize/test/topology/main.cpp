@@ -0,0 +1,150 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace fiberize;
+using namespace fiberize::detail;
+
+/**
+ * A fake /sys/devices/system/cpu in a temporary directory.
+ */
+class FakeSysfs : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char pattern[] = "/tmp/fiberize-topology-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(pattern));
+        root = pattern;
+        dirs.push_back(root);
+    }
+
+    void TearDown() override {
+        for (auto file = files.rbegin(); file != files.rend(); ++file)
+            unlink(file->c_str());
+        for (auto dir = dirs.rbegin(); dir != dirs.rend(); ++dir)
+            rmdir(dir->c_str());
+    }
+
+    void makeDir(const std::string& path) {
+        mkdir(path.c_str(), 0700);
+        dirs.push_back(path);
+    }
+
+    void writeFile(const std::string& path, uint32_t value) {
+        std::ofstream(path) << value << std::endl;
+        files.push_back(path);
+    }
+
+    /**
+     * Adds a CPU. Without a node it gets no "nodeN" entry.
+     */
+    void addCpu(uint32_t cpu, uint32_t package, uint32_t core, int node) {
+        std::string dir = root + "/cpu" + std::to_string(cpu);
+        makeDir(dir);
+        makeDir(dir + "/topology");
+        writeFile(dir + "/topology/core_id", core);
+        writeFile(dir + "/topology/physical_package_id", package);
+        if (node >= 0)
+            makeDir(dir + "/node" + std::to_string(node));
+    }
+
+    std::string root;
+    std::vector<std::string> dirs;
+    std::vector<std::string> files;
+};
+
+TEST_F(FakeSysfs, ReadsCoresPackagesAndNodes) {
+    // Three packages with two cores of two hardware threads each. Packages 0 and 1 share node 0.
+    for (uint32_t cpu = 0; cpu < 12; ++cpu)
+        addCpu(cpu, cpu / 4, (cpu / 2) % 2, cpu < 8 ? 0 : 1);
+
+    Topology topology = Topology::read(root, {});
+    const auto& cpus = topology.cpus();
+    ASSERT_EQ(12u, cpus.size());
+    EXPECT_EQ(2u, topology.nodes());
+
+    // Every physical core comes once before any second hardware thread.
+    for (size_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(0u, cpus[i].cpu % 2);
+        EXPECT_EQ(1u, cpus[i + 6].cpu % 2);
+    }
+
+    std::vector<CpuLocation> byNumber(12);
+    for (const CpuLocation& location : cpus)
+        byNumber[location.cpu] = location;
+
+    auto levels = neighbours(byNumber, 0);
+    EXPECT_EQ(std::vector<size_t>({1}), levels[size_t(Distance::SameCore)]);
+    EXPECT_EQ(std::vector<size_t>({2, 3}), levels[size_t(Distance::SamePackage)]);
+    EXPECT_EQ(std::vector<size_t>({4, 5, 6, 7}), levels[size_t(Distance::SameNode)]);
+    EXPECT_EQ(std::vector<size_t>({8, 9, 10, 11}), levels[size_t(Distance::Remote)]);
+}
+
+TEST_F(FakeSysfs, SplitsPackagesIntoNodes) {
+    // One package of four cores split into two nodes, as with sub-NUMA clustering.
+    for (uint32_t cpu = 0; cpu < 4; ++cpu)
+        addCpu(cpu, 0, cpu, cpu < 2 ? 0 : 1);
+
+    Topology topology = Topology::read(root, {});
+    const auto& cpus = topology.cpus();
+    ASSERT_EQ(4u, cpus.size());
+    EXPECT_EQ(2u, topology.nodes());
+
+    std::vector<CpuLocation> byNumber(4);
+    for (const CpuLocation& location : cpus)
+        byNumber[location.cpu] = location;
+
+    // The other node of the same package is remote.
+    auto levels = neighbours(byNumber, 0);
+    EXPECT_TRUE(levels[size_t(Distance::SameCore)].empty());
+    EXPECT_EQ(std::vector<size_t>({1}), levels[size_t(Distance::SamePackage)]);
+    EXPECT_TRUE(levels[size_t(Distance::SameNode)].empty());
+    EXPECT_EQ(std::vector<size_t>({2, 3}), levels[size_t(Distance::Remote)]);
+}
+
+TEST_F(FakeSysfs, FallsBackForMissingEntries) {
+    // No node entries, and nothing at all for CPUs 2 and 3.
+    addCpu(0, 0, 0, -1);
+    addCpu(1, 0, 0, -1);
+
+    Topology topology = Topology::read(root, {0, 1, 2, 3});
+    const auto& cpus = topology.cpus();
+    ASSERT_EQ(4u, cpus.size());
+    EXPECT_EQ(1u, topology.nodes());
+
+    std::vector<CpuLocation> byNumber(4);
+    for (const CpuLocation& location : cpus) {
+        EXPECT_EQ(0u, location.node);
+        EXPECT_EQ(0u, location.package);
+        byNumber[location.cpu] = location;
+    }
+    EXPECT_EQ(2u, byNumber[2].core);
+    EXPECT_EQ(3u, byNumber[3].core);
+
+    // CPUs 0 and 1 are threads of one core, the missing ones are separate cores of the package.
+    auto levels = neighbours(byNumber, 0);
+    EXPECT_EQ(std::vector<size_t>({1}), levels[size_t(Distance::SameCore)]);
+    EXPECT_EQ(std::vector<size_t>({2, 3}), levels[size_t(Distance::SamePackage)]);
+    EXPECT_TRUE(levels[size_t(Distance::SameNode)].empty());
+    EXPECT_TRUE(levels[size_t(Distance::Remote)].empty());
+}
+
+TEST_F(FakeSysfs, FallsBackToHardwareThreads) {
+    // Nothing in sysfs and no affinity mask.
+    Topology topology = Topology::read(root, {});
+    const auto& cpus = topology.cpus();
+    ASSERT_FALSE(cpus.empty());
+    EXPECT_EQ(1u, topology.nodes());
+
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        auto levels = neighbours(cpus, i);
+        EXPECT_TRUE(levels[size_t(Distance::SameCore)].empty());
+        EXPECT_EQ(cpus.size() - 1, levels[size_t(Distance::SamePackage)].size());
+    }
+}
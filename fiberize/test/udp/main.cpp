@@ -0,0 +1,108 @@
+#include <fiberize/fiberize.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace fiberize;
+
+FiberSystem fiberSystem;
+
+TEST(Udp, SendAndReceive) {
+    int server = io::udp::bind("127.0.0.1", 0);
+    int client = io::udp::bind("127.0.0.1", 0);
+    io::Endpoint serverEndpoint = io::Endpoint::local(server);
+
+    // The header and the payload are gathered from two buffers.
+    char header[] = "Hello ";
+    char payload[] = "world!";
+    io::Buffer out[] = { io::Buffer(header, 6), io::Buffer(payload, 6) };
+    EXPECT_EQ(12u, io::udp::sendto(client, out, 2, serverEndpoint));
+    EXPECT_EQ(12u, io::udp::sendto<io::Block>(client, out, 2, serverEndpoint));
+    EXPECT_EQ(12u, io::udp::sendto<io::Async>(client, out, 2, serverEndpoint).await().get());
+
+    char data[64];
+    io::Buffer in(data, sizeof(data));
+    io::Endpoint from;
+    EXPECT_EQ(12u, io::udp::recvfrom(server, &in, 1, &from));
+    EXPECT_EQ("Hello world!", std::string(data, 12));
+    EXPECT_EQ(io::Endpoint::local(client).port(), from.port());
+    EXPECT_EQ("127.0.0.1", from.address());
+
+    EXPECT_EQ(12u, io::udp::recvfrom<io::Block>(server, &in, 1, nullptr));
+    EXPECT_EQ(12u, io::udp::recvfrom<io::Async>(server, &in, 1, nullptr).await().get());
+
+    io::close(client);
+    io::close(server);
+}
+
+TEST(Udp, Batches) {
+    static const uint count = 100;
+
+    int server = io::udp::bind("127.0.0.1", 0);
+    int client = io::udp::bind("127.0.0.1", 0);
+    uint16_t serverPort = io::Endpoint::local(server).port();
+    uint16_t clientPort = io::Endpoint::local(client).port();
+
+    // Receive in another fiber, which has to wait for the datagrams.
+    auto receiver = fiberSystem.future([server, clientPort] () {
+        std::vector<std::string> messages;
+        std::vector<char> data(count * 16);
+        std::vector<io::Buffer> buffers;
+        std::vector<io::udp::Datagram> datagrams(count);
+        for (uint i = 0; i < count; ++i) {
+            buffers.emplace_back(&data[i * 16], 16);
+        }
+
+        while (messages.size() < count) {
+            uint left = count - messages.size();
+            for (uint i = 0; i < left; ++i) {
+                datagrams[i].bufs = &buffers[i];
+                datagrams[i].nbufs = 1;
+            }
+
+            uint n = io::udp::recvmmsg(server, datagrams.data(), left);
+            EXPECT_LT(0u, n);
+            for (uint i = 0; i < n; ++i) {
+                messages.emplace_back(datagrams[i].bufs->data(), datagrams[i].length);
+                EXPECT_EQ(clientPort, datagrams[i].peer.port());
+            }
+        }
+        return messages;
+    }).run();
+
+    std::vector<std::string> sent;
+    std::vector<io::Buffer> buffers;
+    std::vector<io::udp::Datagram> datagrams(count);
+    for (uint i = 0; i < count; ++i) {
+        sent.push_back("message " + std::to_string(i));
+    }
+    for (uint i = 0; i < count; ++i) {
+        buffers.emplace_back(&sent[i][0], sent[i].size());
+    }
+    for (uint i = 0; i < count; ++i) {
+        datagrams[i].bufs = &buffers[i];
+        datagrams[i].nbufs = 1;
+        datagrams[i].peer = io::Endpoint("127.0.0.1", serverPort);
+    }
+
+    EXPECT_EQ(count, io::udp::sendmmsg(client, datagrams.data(), count));
+    for (uint i = 0; i < count; ++i) {
+        EXPECT_EQ(sent[i].size(), datagrams[i].length);
+    }
+
+    // Loopback keeps the order.
+    EXPECT_EQ(sent, receiver.await().get());
+
+    io::close(client);
+    io::close(server);
+}
+
+TEST(Udp, InvalidAddress) {
+    EXPECT_THROW(io::udp::bind("not an address", 0), std::system_error);
+}
+
+int main(int argc, char **argv) {
+    fiberSystem.fiberize();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}